@@ -17,6 +17,7 @@ public class GameInstance extends Thread
         input_master = new ArrayList<Integer>();
         input_rest = new ArrayList<Integer>();
         names = new HashMap<Integer, String>();
+        watchers = new ArrayList<Integer>();
     }
 
     public void handleMessage(Message m) {
@@ -77,7 +78,16 @@ public class GameInstance extends Thread
                                    + "Proper syntax is '#name NAME'");
             } else {
                 names.put(m.id, m.message.substring(6));
+                // Tell whoever asked
+                for (Integer i : watchers)
+                    input_all.get(i).println("#joined " + m.id + " " + names.get(m.id));
             }
+        } else if (m.message.equals("#notify")) {
+            // Tell the client about everyone named so far, and later ones as they
+            // name themselves
+            watchers.add(m.id);
+            for (Map.Entry<Integer, String> me : names.entrySet())
+                reply(m, "#joined " + me.getKey() + " " + me.getValue());
         } else if (m.message.equals("#players")) {
             // Query number of players
             System.out.println("Received #players query from " + names.get(m.id)
@@ -195,6 +205,8 @@ public class GameInstance extends Thread
     private ArrayList<Integer> input_rest;
     private LinkedBlockingQueue<Message> messages;
     private HashMap<Integer, String> names;
+    // Clients told as others name themselves
+    private ArrayList<Integer> watchers;
     private ArrayList<Process> processes;
     private ArrayList<String> programs;
     private boolean running;
@@ -78,7 +78,16 @@ public class GameInstance extends Thread {
                      + "Proper syntax is '#name NAME'");
       } else {
         names.put(m.id, m.message.substring(6));
+        // Tell whoever asked
+        for (Integer i : watchers)
+          input_all.get(i).println("#joined " + m.id + " " + names.get(m.id));
       }
+    } else if (m.message.equals("#notify")) {
+      // Tell the client about everyone named so far, and later ones as they
+      // name themselves
+      watchers.add(m.id);
+      for (Map.Entry<Integer, String> me : names.entrySet())
+        reply(m, "#joined " + me.getKey() + " " + me.getValue());
     } else if (m.message.equals("#players")) {
       // Query number of players
       reply(m, "#players " + names.size());
@@ -208,6 +217,8 @@ public class GameInstance extends Thread {
   private ArrayList<Integer> input_rest = new ArrayList<>();
   private LinkedBlockingQueue<Message> messages = new LinkedBlockingQueue<>();
   private HashMap<Integer, String> names = new HashMap<>();
+  // Clients told as others name themselves
+  private ArrayList<Integer> watchers = new ArrayList<>();
   private ArrayList<Process> processes = new ArrayList<>();
   private AtomicBoolean running = new AtomicBoolean(false);
   private ArrayList<ProcessControlBlock> pcbs = new ArrayList<>();
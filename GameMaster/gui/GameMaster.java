@@ -505,6 +505,8 @@ public class GameMaster<BoardPanelType extends AbstractBoardPanel> {
       moveTableModel.addMoveMsg(msg);
     } else if (msg.startsWith("GUI")) {
       moveTableModel.addGUIState(msg);
+    } else if (msg.startsWith("DELTA")) {
+      moveTableModel.addGUIDelta(msg);
     }
   }
 
@@ -768,6 +770,9 @@ public class GameMaster<BoardPanelType extends AbstractBoardPanel> {
 
     private String moveCache = "";
 
+    // Tokens of the last board, which DELTA lines change
+    private String[] lastBoard = null;
+
     @Override
     public int getColumnCount() {
       return columnNames.length;
@@ -840,6 +845,7 @@ public class GameMaster<BoardPanelType extends AbstractBoardPanel> {
       m.elapsed = p1[4].substring(9).trim();
       m.state = p2[1].trim();
       m.nextMoves = p2[2].trim();
+      lastBoard = m.state.split(" ");
 
       data.add(m);
       moveCache = "";
@@ -847,8 +853,42 @@ public class GameMaster<BoardPanelType extends AbstractBoardPanel> {
       fireTableRowsInserted(data.size(), data.size());
     }
 
+    public void addGUIDelta(String msg) {
+      // Only valid after a GUI line gave the whole board
+      if (lastBoard == null)
+        return;
+
+      /*
+        Example moderator line, from the moderator's --gui-deltas, giving the
+        tokens of the last board that changed counting from 0:
+        DELTA | 0=1 19=1 27=0 | 1, 3; 1, 19; 2, 3; 2, 20; 4, 3; 4, 6;
+      */
+      String[] p2 = msg.split("\\|");
+      for (String change : p2[1].trim().split(" ")) {
+        int equals = change.indexOf('=');
+        if (equals < 0)
+          continue;
+        try {
+          int idx = Integer.parseInt(change.substring(0, equals));
+          if (idx >= 0 && idx < lastBoard.length)
+            lastBoard[idx] = change.substring(equals + 1);
+        } catch (NumberFormatException e) {
+          System.err.println("Invalid board change: " + change);
+        }
+      }
+
+      StringBuilder state = new StringBuilder();
+      for (String token : lastBoard) {
+        if (state.length() > 0)
+          state.append(' ');
+        state.append(token);
+      }
+      addGUIState("GUI | " + state + " |" + (p2.length > 2 ? p2[2] : ""));
+    }
+
     public void clearAll() {
       data.clear();
+      lastBoard = null;
       fireTableDataChanged();
     }
 
@@ -89,8 +89,10 @@ public class HexGameBoard extends AbstractBoardPanel {
       e.printStackTrace();
     }
 
-    // Split apart moves
-    String[] moveTokens = nextMoves.split(";");
+    // Split apart moves, of which there are none when the game is over or the
+    // moderator leaves them out
+    String[] moveTokens = nextMoves.trim().isEmpty() ? new String[0]
+                                                     : nextMoves.split(";");
     moves.clear();
     movesCount = 0;
     movesDupes = false;
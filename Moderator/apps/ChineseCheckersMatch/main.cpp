@@ -0,0 +1,95 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/Client.h"
+#include "ChineseCheckers/State.h"
+#include "Common/Match.h"
+#include "Common/Options.h"
+
+std::string formatSeconds(double seconds, int moves);
+std::string formatMegabytes(long long bytes);
+
+int main(int argc, char **argv) {
+  // Defaults match ChineseCheckersModerator
+  Common::MatchSpec spec;
+  std::vector<std::string> agents;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--quiet") {
+      spec.options.quiet = true;
+      spec.options.printBoard = false;
+    } else if (arg == "--gui-deltas") {
+      spec.options.guiDeltas = true;
+    } else if (arg == "--gui-no-moves") {
+      spec.options.guiMoves = false;
+    } else if (arg == "--log") {
+      spec.options.logGame = true;
+    } else if (arg == "--start" && i + 1 < argc) {
+      spec.options.startState = argv[++i];
+    } else if (!Common::parseMatchOption(argc, argv, i, spec)) {
+      agents.push_back(arg);
+    }
+  }
+
+  if (agents.size() != 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--quiet] [--gui-deltas] [--gui-no-moves] [--enforce [SECONDS]] [--clock BASE+INC] [--announce-time]"
+                 " [--adjudicate] [--max-plies N]"
+                 " [--log] [--async-log MS] [--allow-dupe-states] [--start STATE]"
+                 " [--cpus LIST] [--memory MB]"
+                 " [--address-space MB] AGENT1 AGENT2\n";
+    return EXIT_FAILURE;
+  }
+  spec.commands = {{agents[0], agents[1]}};
+
+  Common::Match<ChineseCheckers::State, ChineseCheckers::Client> match;
+  if (match.start(spec))
+    match.play();
+
+  auto result = match.result();
+  if (result.winner < 0) {
+    std::cerr << "No result: " << result.error << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  unsigned winner = static_cast<unsigned>(result.winner);
+  std::cout << "FINAL " << result.names[winner] << " BEATS "
+            << result.names[1 - winner] << std::endl;
+
+  for (unsigned player = 0; player < 2; ++player) {
+    int moves = result.playerMoves[player];
+    std::cout << result.names[player] << ": " << moves << " moves, "
+              << formatSeconds(result.moveWallTime[player], moves) << " wall, "
+              << formatSeconds(result.moveCpuTime[player], moves)
+              << " CPU, " << formatSeconds(result.gameCpuTime[player], 0)
+              << " CPU in the game, " << formatMegabytes(result.peakMemory[player])
+              << " peak memory" << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+std::string formatSeconds(double seconds, int moves) {
+  if (seconds < 0.0)
+    return "unknown";
+
+  std::stringstream out;
+  out << std::fixed << std::setprecision(3) << seconds << "s";
+  if (moves > 0)
+    out << " (" << seconds / moves << "s a move)";
+  return out.str();
+}
+
+std::string formatMegabytes(long long bytes) {
+  if (bytes < 0)
+    return "unknown";
+
+  std::stringstream out;
+  out << std::fixed << std::setprecision(1)
+      << static_cast<double>(bytes) / (1024 * 1024) << " MB";
+  return out.str();
+}
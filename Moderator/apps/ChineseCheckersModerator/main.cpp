@@ -1,71 +1,56 @@
-#include <algorithm>
 #include <cstdlib>
 #include <iostream>
-#include <stdexcept>
 #include <string>
 
 #include "Common/Moderator.h"
+#include "Common/Options.h"
 #include "ChineseCheckers/State.h"
 #include "ChineseCheckers/Client.h"
 
-bool commandExists(char **begin, char **end, const std::string &name);
-char *getOption(char **begin, char **end, const std::string &name);
-
 int main(int argc, char **argv) {
-  // Defaults
-  bool quiet = false;
-  bool printBoard = true; // to stderr
-  double turnTimeLimit = 30.0; // in seconds
-  bool logGame = false; // to file
-  bool enforceTimeLimit = false;
-  bool forbidDuplicateStates = true;
-
-  // Check if command line arguments overrides any of these
-  if (commandExists(argv, argv + argc, "--quiet")) {
-    quiet = true;
-    printBoard = false;
-  }
-
-  if (commandExists(argv, argv + argc, "--enforce")) {
-    enforceTimeLimit = true;
-    char *limit = getOption(argv, argv + argc, "--enforce");
-    if (limit != nullptr) {
-      try {
-        turnTimeLimit = std::stod(limit);
-      } catch (std::invalid_argument e) {
-        std::cerr << "Invalid timeout of (std::invalid_argument) " << limit << std::endl;
-      } catch (std::out_of_range e) {
-        std::cerr << "Invalid timeout of (std::out_of_range) " << limit << std::endl;
+  // Defaults: print the board to stderr, a 30 second limit that is not
+  // enforced, no log file and no duplicated states
+  Common::ModeratorOptions options;
+
+  // Check if command line arguments override any of these
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--quiet") {
+      options.quiet = true;
+      options.printBoard = false;
+    } else if (arg == "--gui-deltas") {
+      options.guiDeltas = true;
+    } else if (arg == "--gui-no-moves") {
+      options.guiMoves = false;
+    } else if (arg == "--log") {
+      options.logGame = true;
+    } else if (arg == "--start") {
+      const char *state = i + 1 < argc ? argv[++i] : nullptr;
+      ChineseCheckers::State start;
+      if (state == nullptr || !start.loadState(state) || start.gameOver()) {
+        std::cerr << "Cannot start from state " << (state ? state : "nothing")
+                  << std::endl;
+        return EXIT_FAILURE;
       }
+      options.startState = state;
+    } else {
+      Common::parseModeratorOption(argc, argv, i, options);
     }
   }
 
-  if (commandExists(argv, argv + argc, "--allow-dupe-states")) {
-    forbidDuplicateStates = false;
-  }
-
-  if (!printBoard)
+  if (!options.printBoard)
     std::cout << "--quiet enabled. Will not print GUI updates to std::err" << std::endl;
 
-  if (enforceTimeLimit)
-    std::cout << "Will enforce time limit of " << turnTimeLimit << " seconds." << std::endl;
+  if (options.enforceTimeLimit)
+    std::cout << "Will enforce time limit of " << options.turnTimeLimit
+              << " seconds." << std::endl;
+
+  if (options.clockBase > 0.0)
+    std::cout << "Will give each player " << options.clockBase << " seconds plus "
+              << options.clockIncrement << " per move." << std::endl;
 
   Common::Moderator<ChineseCheckers::State, ChineseCheckers::Client> m;
-  m.playGame(printBoard, quiet, turnTimeLimit, logGame, enforceTimeLimit, forbidDuplicateStates);
+  m.playGame(options);
 
   return EXIT_SUCCESS;
 }
-
-bool commandExists(char **begin, char **end, const std::string &name) {
-  return std::find(begin, end, name) != end;
-}
-
-char *getOption(char **begin, char **end, const std::string &name)
-{
-    char **itr = std::find(begin, end, name);
-    if (itr != end && ++itr != end)
-    {
-        return *itr;
-    }
-    return nullptr;
-}
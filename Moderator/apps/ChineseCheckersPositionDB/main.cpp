@@ -0,0 +1,144 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/OpeningBook.h"
+#include "ChineseCheckers/PositionDB.h"
+#include "ChineseCheckers/State.h"
+#include "Common/File.h"
+#include "Common/String.h"
+
+int build(int argc, char **argv);
+int query(int argc, char **argv);
+int book(int argc, char **argv);
+void usage(const char *program);
+
+int main(int argc, char **argv) {
+  if (argc >= 4 && std::string(argv[1]) == "build")
+    return build(argc, argv);
+  if (argc == 4 && std::string(argv[1]) == "query")
+    return query(argc, argv);
+  if (argc >= 4 && std::string(argv[1]) == "book")
+    return book(argc, argv);
+
+  usage(argv[0]);
+  return EXIT_FAILURE;
+}
+
+void usage(const char *program) {
+  std::cerr << "Usage: " << program << " build DB [--base BASE_DB] LOG_DIR...\n"
+            << "       " << program << " query DB STATE\n"
+            << "       " << program << " book DB BOOK [--min-visits N]\n"
+            << "build merges the games in the logs into DB, or into BASE_DB "
+               "when given.\n"
+            << "query prints what is known about STATE, given in the "
+               "DUMPSTATE format.\n"
+            << "book writes the best moves of positions reached at least N "
+               "times, 10 by default, to the opening book BOOK.\n";
+}
+
+int build(int argc, char **argv) {
+  std::string path = argv[2];
+  std::string basePath = path;
+  std::vector<std::string> logs;
+
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--base" && i + 1 < argc)
+      basePath = argv[++i];
+    else if (!Common::listFiles(arg, logs))
+      logs.push_back(arg);
+  }
+
+  // Without an existing database we start from nothing
+  ChineseCheckers::PositionDB base;
+  if (base.open(basePath))
+    std::cout << "Merging into " << base.size() << " positions from "
+              << basePath << "\n";
+  else if (basePath != path)
+    std::cerr << "Unable to open base database " << basePath << "\n";
+
+  ChineseCheckers::PositionDBBuilder builder;
+  for (const auto &log : logs) {
+    if (!builder.addLog(log))
+      std::cerr << "Unable to read " << log << "\n";
+  }
+  std::cout << "Read " << builder.games() << " decided games from "
+            << logs.size() << " logs\n";
+
+  if (!builder.write(path, base)) {
+    std::cerr << "Unable to write " << path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  ChineseCheckers::PositionDB result;
+  if (!result.open(path)) {
+    std::cerr << "Unable to read back " << path << "\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << "Wrote " << result.size() << " positions to " << path << "\n";
+  return EXIT_SUCCESS;
+}
+
+int query(int, char **argv) {
+  ChineseCheckers::PositionDB db;
+  if (!db.open(argv[2])) {
+    std::cerr << "Unable to open database " << argv[2] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  ChineseCheckers::State gs;
+  if (!gs.loadState(argv[3])) {
+    std::cerr << "Invalid state '" << argv[3] << "'\n";
+    return EXIT_FAILURE;
+  }
+
+  const ChineseCheckers::PositionStats *stats = db.find(gs);
+  if (stats == nullptr) {
+    std::cout << "Position not found\n";
+    return EXIT_SUCCESS;
+  }
+
+  std::cout << "Visits: " << stats->visits << "\n"
+            << "Player 1 wins: " << stats->wins[0] << "\n"
+            << "Player 2 wins: " << stats->wins[1] << "\n";
+
+  ChineseCheckers::Move m;
+  if (db.bestMove(gs, m))
+    std::cout << "Best move: " << m.from << ", " << m.to << "\n";
+  else
+    std::cout << "Best move: unknown\n";
+  return EXIT_SUCCESS;
+}
+
+int book(int argc, char **argv) {
+  uint32_t minVisits = 10;
+  if (argc == 6 && std::string(argv[4]) == "--min-visits") {
+    unsigned visits;
+    if (Common::parseUnsigned(argv[5], visits) != Common::ParseError::None) {
+      std::cerr << "Invalid visit count of " << argv[5] << "\n";
+      return EXIT_FAILURE;
+    }
+    minVisits = visits;
+  } else if (argc != 4) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  ChineseCheckers::PositionDB db;
+  if (!db.open(argv[2])) {
+    std::cerr << "Unable to open database " << argv[2] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  long written = ChineseCheckers::OpeningBook::build(argv[3], db, minVisits);
+  if (written < 0) {
+    std::cerr << "Unable to write " << argv[3] << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Wrote " << written << " positions to " << argv[3] << "\n";
+  return EXIT_SUCCESS;
+}
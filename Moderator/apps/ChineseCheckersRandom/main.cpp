@@ -6,14 +6,25 @@
 #include "ChineseCheckers/Client.h"
 
 int main(int argc, char *argv[]) {
-  // Determine our name from command line
-  std::string name;
-  if (argc >= 2)
-    name = argv[1];
-  else
-    name = "Random";
+  // Determine our name, opening book and protocol from command line
+  std::string name = "Random";
+  std::string book;
+  bool frames = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--book" && i + 1 < argc)
+      book = argv[++i];
+    else if (arg == "--binary")
+      frames = true;
+    else
+      name = arg;
+  }
 
   Common::Random<ChineseCheckers::State, ChineseCheckers::Client> rp(name);
+  if (!book.empty())
+    rp.useBook(book);
+  if (frames)
+    rp.useFrames();
   rp.playGame();
 
   return EXIT_SUCCESS;
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "ChineseCheckers/GameLog.h"
+#include "ChineseCheckers/State.h"
+#include "Common/File.h"
+#include "Common/Options.h"
+
+// Everything found while replaying a share of the logs
+struct Report {
+  size_t files = 0;
+  size_t unreadable = 0;
+  size_t games = 0;
+
+  size_t invalidMoves = 0;
+  size_t duplicateStates = 0;
+  size_t mismatchedFinals = 0;
+  size_t missingFinals = 0;
+  size_t unverifiedFinals = 0;
+
+  size_t shortestGame = SIZE_MAX;
+  size_t longestGame = 0;
+  uint64_t totalPlies = 0;
+
+  // Indexed by ply
+  std::vector<uint64_t> branchingSum;
+  std::vector<uint64_t> branchingCount;
+
+  // (file index, line, description)
+  std::vector<std::tuple<size_t, size_t, std::string>> problems;
+};
+
+void replayFile(const std::string &path, size_t fileIdx,
+                bool forbidDuplicateStates, ChineseCheckers::State &gs,
+                Report &report);
+void replayGame(const ChineseCheckers::LoggedGame &game, size_t fileIdx,
+                bool forbidDuplicateStates, ChineseCheckers::State &gs,
+                Report &report);
+void merge(Report &into, const Report &from);
+void printReport(const Report &report, const std::vector<std::string> &files,
+                 bool quiet);
+
+int main(int argc, char **argv) {
+  // Defaults
+  bool quiet = false;
+  bool forbidDuplicateStates = true;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--quiet") {
+      quiet = true;
+    } else if (arg == "--allow-dupe-states") {
+      forbidDuplicateStates = false;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = static_cast<unsigned>(
+          Common::parseCount(argv[++i], static_cast<int>(threads)));
+    } else {
+      paths.push_back(arg);
+    }
+  }
+
+  if (paths.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--threads N] [--allow-dupe-states] [--quiet] LOG_DIR...\n";
+    return EXIT_FAILURE;
+  }
+
+  // Collect the logs, plain files may be given directly too
+  std::vector<std::string> files;
+  for (const auto &path : paths) {
+    if (!Common::listFiles(path, files))
+      files.push_back(path);
+  }
+
+  // Files are handed out one at a time so a few long logs cannot leave the
+  // other threads idle
+  std::atomic<size_t> nextFile(0);
+  std::vector<Report> reports(threads);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      ChineseCheckers::State gs;
+      for (size_t i = nextFile++; i < files.size(); i = nextFile++)
+        replayFile(files[i], i, forbidDuplicateStates, gs, reports[t]);
+    });
+  }
+
+  Report total;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers[t].join();
+    merge(total, reports[t]);
+  }
+
+  printReport(total, files, quiet);
+
+  bool clean = total.unreadable == 0 && total.invalidMoves == 0 &&
+               total.duplicateStates == 0 && total.mismatchedFinals == 0 &&
+               total.missingFinals == 0;
+  return clean ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void replayFile(const std::string &path, size_t fileIdx,
+                bool forbidDuplicateStates, ChineseCheckers::State &gs,
+                Report &report) {
+  ++report.files;
+
+  Common::MappedFile file;
+  if (!file.open(path)) {
+    ++report.unreadable;
+    report.problems.emplace_back(fileIdx, 0, "unable to read file");
+    return;
+  }
+
+  std::vector<ChineseCheckers::LoggedGame> games;
+  ChineseCheckers::parseGameLog(file.begin(), file.end(), games);
+
+  for (const auto &game : games)
+    replayGame(game, fileIdx, forbidDuplicateStates, gs, report);
+}
+
+void replayGame(const ChineseCheckers::LoggedGame &game, size_t fileIdx,
+                bool forbidDuplicateStates, ChineseCheckers::State &gs,
+                Report &report) {
+  ++report.games;
+  gs.reset();
+  if (!game.startState.empty() && !gs.loadState(game.startState)) {
+    ++report.invalidMoves;
+    report.problems.emplace_back(fileIdx, game.line, "invalid start state " +
+                                                         game.startState);
+    return;
+  }
+
+  std::set<ChineseCheckers::Move> moves;
+  size_t ply = 0;
+  for (const auto &logged : game.moves) {
+    if (gs.gameOver()) {
+      ++report.invalidMoves;
+      report.problems.emplace_back(fileIdx, logged.line,
+                                   "move played after the game was over");
+      return;
+    }
+
+    gs.getMoves(moves);
+    if (report.branchingSum.size() <= ply) {
+      report.branchingSum.resize(ply + 1, 0);
+      report.branchingCount.resize(ply + 1, 0);
+    }
+    report.branchingSum[ply] += moves.size();
+    ++report.branchingCount[ply];
+
+    if (moves.find(logged.move) == moves.end()) {
+      std::stringstream problem;
+      problem << "invalid move " << logged.move << " in state "
+              << gs.dumpState();
+      ++report.invalidMoves;
+      report.problems.emplace_back(fileIdx, logged.line, problem.str());
+      return;
+    }
+
+    gs.applyMove(logged.move);
+    ++ply;
+
+    if (forbidDuplicateStates && gs.seenDuplicatedState()) {
+      std::stringstream problem;
+      problem << "move " << logged.move << " duplicates an earlier state";
+      ++report.duplicateStates;
+      report.problems.emplace_back(fileIdx, logged.line, problem.str());
+      return;
+    }
+  }
+
+  report.shortestGame = std::min(report.shortestGame, ply);
+  report.longestGame = std::max(report.longestGame, ply);
+  report.totalPlies += ply;
+
+  if (!game.hasFinal) {
+    ++report.missingFinals;
+    report.problems.emplace_back(fileIdx, game.line, "game has no FINAL");
+    return;
+  }
+
+  // Work out who the moderator should have declared the winner
+  bool player1Won;
+  if (gs.gameOver()) {
+    // Mirrors Moderator::playGame, which awards anything but a player 1 win
+    // to player 2
+    player1Won = gs.winner() == 1;
+  } else if (game.forfeit == ChineseCheckers::Forfeit::RaceAdjudicated) {
+    player1Won = gs.raceWinner() == 1;
+  } else if (game.forfeit == ChineseCheckers::Forfeit::PlyLimit) {
+    player1Won = gs.raceLeader() == 1;
+  } else if (game.forfeit != ChineseCheckers::Forfeit::None) {
+    // The player to move forfeited
+    player1Won = gs.getCurrentPlayer() == 2;
+  } else {
+    // Out of turn messages are not logged, so nothing to check against
+    ++report.unverifiedFinals;
+    return;
+  }
+
+  const std::string &winner = player1Won ? game.player1 : game.player2;
+  const std::string &loser = player1Won ? game.player2 : game.player1;
+  if (game.winner != winner || game.loser != loser) {
+    std::stringstream problem;
+    problem << "FINAL " << game.winner << " BEATS " << game.loser
+            << " but replay gives " << winner << " BEATS " << loser;
+    ++report.mismatchedFinals;
+    report.problems.emplace_back(fileIdx, game.finalLine, problem.str());
+  }
+}
+
+void merge(Report &into, const Report &from) {
+  into.files += from.files;
+  into.unreadable += from.unreadable;
+  into.games += from.games;
+  into.invalidMoves += from.invalidMoves;
+  into.duplicateStates += from.duplicateStates;
+  into.mismatchedFinals += from.mismatchedFinals;
+  into.missingFinals += from.missingFinals;
+  into.unverifiedFinals += from.unverifiedFinals;
+  into.shortestGame = std::min(into.shortestGame, from.shortestGame);
+  into.longestGame = std::max(into.longestGame, from.longestGame);
+  into.totalPlies += from.totalPlies;
+
+  if (into.branchingSum.size() < from.branchingSum.size()) {
+    into.branchingSum.resize(from.branchingSum.size(), 0);
+    into.branchingCount.resize(from.branchingCount.size(), 0);
+  }
+  for (size_t i = 0; i < from.branchingSum.size(); ++i) {
+    into.branchingSum[i] += from.branchingSum[i];
+    into.branchingCount[i] += from.branchingCount[i];
+  }
+
+  into.problems.insert(into.problems.end(), from.problems.begin(),
+                       from.problems.end());
+}
+
+void printReport(const Report &report, const std::vector<std::string> &files,
+                 bool quiet) {
+  auto problems = report.problems;
+  std::sort(problems.begin(), problems.end());
+  for (const auto &p : problems)
+    std::cout << files[std::get<0>(p)] << ":" << std::get<1>(p) << ": "
+              << std::get<2>(p) << "\n";
+
+  std::cout << "Files:                 " << report.files << " ("
+            << report.unreadable << " unreadable)\n"
+            << "Games:                 " << report.games << "\n"
+            << "Invalid moves:         " << report.invalidMoves << "\n"
+            << "Duplicate states:      " << report.duplicateStates << "\n"
+            << "Mismatched FINAL:      " << report.mismatchedFinals << "\n"
+            << "Missing FINAL:         " << report.missingFinals << "\n"
+            << "Unverifiable FINAL:    " << report.unverifiedFinals << "\n";
+
+  size_t completed = report.games - report.invalidMoves -
+                     report.duplicateStates;
+  if (completed > 0) {
+    std::cout << "Game length (plies):   min " << report.shortestGame
+              << ", mean " << std::fixed << std::setprecision(1)
+              << static_cast<double>(report.totalPlies) /
+                     static_cast<double>(completed)
+              << ", max " << report.longestGame << "\n";
+  }
+
+  if (quiet)
+    return;
+
+  std::cout << "Branching factor by ply:\n"
+            << std::setw(6) << "ply" << std::setw(10) << "games"
+            << std::setw(10) << "mean" << "\n";
+  for (size_t i = 0; i < report.branchingSum.size(); ++i) {
+    std::cout << std::setw(6) << i + 1 << std::setw(10)
+              << report.branchingCount[i] << std::setw(10)
+              << static_cast<double>(report.branchingSum[i]) /
+                     static_cast<double>(report.branchingCount[i])
+              << "\n";
+  }
+}
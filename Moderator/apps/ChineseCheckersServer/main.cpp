@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChineseCheckers/Client.h"
+#include "ChineseCheckers/State.h"
+#include "Common/Options.h"
+#include "Common/Server.h"
+
+// Time an agent spent over the games with a result
+struct AgentTime {
+  int moves = 0;
+  double wall = 0.0;
+  double cpu = 0.0;
+  // CPU time over whole games
+  double game = 0.0;
+  // Whether CPU time could be measured in every game
+  bool known = true;
+  // The most bytes resident in any game, -1 if unknown
+  long long peakMemory = -1;
+};
+
+int main(int argc, char **argv) {
+  // Defaults
+  int games = 1;
+  int concurrency = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  bool verbose = false;
+  bool pin = false;
+  std::string logDir;
+  std::string openingsPath;
+  // Every game is played with these options and limits
+  Common::MatchSpec base;
+  base.options.printBoard = false;
+  base.options.quiet = true;
+  base.options.diagnostics = nullptr;
+  std::vector<std::string> agents;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--games" && i + 1 < argc) {
+      games = Common::parseCount(argv[++i], games);
+    } else if (arg == "--concurrency" && i + 1 < argc) {
+      concurrency = Common::parseCount(argv[++i], concurrency);
+    } else if (arg == "--log" && i + 1 < argc) {
+      logDir = argv[++i];
+    } else if (arg == "--openings" && i + 1 < argc) {
+      openingsPath = argv[++i];
+    } else if (arg == "--pin") {
+      pin = true;
+    } else if (arg == "--verbose") {
+      verbose = true;
+      base.options.quiet = false;
+      base.options.diagnostics = &std::cerr;
+    } else if (!Common::parseMatchOption(argc, argv, i, base)) {
+      agents.push_back(arg);
+    }
+  }
+
+  if (agents.size() != 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--games N] [--concurrency N] [--log DIR] [--async-log MS]"
+                 " [--enforce SECONDS]"
+                 " [--clock BASE+INC] [--announce-time] [--adjudicate] [--max-plies N]"
+                 " [--allow-dupe-states] [--openings FILE]"
+                 " [--cpus LIST] [--pin] [--memory MB] [--address-space MB]"
+                 " [--verbose] AGENT1 AGENT2\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> openings;
+  if (!openingsPath.empty() &&
+      !Common::readOpenings<ChineseCheckers::State>(openingsPath, openings))
+    return EXIT_FAILURE;
+
+  // Agents take turns at moving first, and each pair of games starts from
+  // the same opening
+  Common::Server<ChineseCheckers::State, ChineseCheckers::Client> server(
+      static_cast<size_t>(concurrency), pin);
+  for (size_t game = 0; game < static_cast<size_t>(games); ++game) {
+    Common::MatchSpec spec = base;
+    spec.commands = {{agents[game % 2], agents[(game + 1) % 2]}};
+    if (!openings.empty())
+      spec.options.startState = openings[(game / 2) % openings.size()];
+    spec.agents.discardErrors = !verbose;
+    if (!logDir.empty()) {
+      spec.options.logGame = true;
+      spec.options.logPath = logDir + "/game-" + std::to_string(game) + ".txt";
+    }
+    server.add(spec);
+  }
+
+  // Tallied by agent, not by colour
+  std::array<int, 2> wins{{0, 0}};
+  std::array<AgentTime, 2> times;
+  int unfinished = 0;
+  bool ok = server.run([&](size_t game, const Common::MatchResult &result) {
+    std::cout << "Game " << game << ": ";
+    if (result.winner < 0) {
+      ++unfinished;
+      std::cout << "no result. " << result.error << std::endl;
+      return;
+    }
+
+    unsigned winner = static_cast<unsigned>(result.winner);
+    ++wins[(winner + game) % 2];
+    std::cout << result.names[winner] << " beats " << result.names[1 - winner]
+              << " in " << result.moves << " moves" << std::endl;
+
+    for (unsigned player = 0; player < 2; ++player) {
+      AgentTime &time = times[(player + game) % 2];
+      time.moves += result.playerMoves[player];
+      time.wall += result.moveWallTime[player];
+      time.cpu += result.moveCpuTime[player];
+      time.game += result.gameCpuTime[player];
+      time.known = time.known && result.moveCpuTime[player] >= 0.0 &&
+                   result.gameCpuTime[player] >= 0.0;
+      time.peakMemory = std::max(time.peakMemory, result.peakMemory[player]);
+    }
+  });
+
+  std::cout << agents[0] << ": " << wins[0] << " wins\n"
+            << agents[1] << ": " << wins[1] << " wins\n"
+            << "No result: " << unfinished << std::endl;
+
+  // Games without a result are left out
+  int decided = games - unfinished;
+  for (unsigned agent = 0; agent < 2; ++agent) {
+    const AgentTime &time = times[agent];
+    if (time.moves == 0)
+      continue;
+    std::cout << std::fixed << std::setprecision(3) << agents[agent] << ": "
+              << time.wall / time.moves << "s wall a move";
+    if (time.known)
+      std::cout << ", " << time.cpu / time.moves << "s CPU a move, "
+                << time.game / decided << "s CPU a game";
+    if (time.peakMemory >= 0)
+      std::cout << std::setprecision(1) << ", "
+                << static_cast<double>(time.peakMemory) / (1024 * 1024)
+                << " MB peak memory";
+    std::cout << std::endl;
+  }
+
+  return ok && unfinished == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ChineseCheckers/Client.h"
+#include "ChineseCheckers/State.h"
+#include "Common/Elo.h"
+#include "Common/Options.h"
+#include "Common/Server.h"
+
+// Results so far, indexed by agent
+struct Crosstable {
+  explicit Crosstable(size_t agents);
+
+  // wins[i][j] is the number of games agent i won against agent j
+  std::vector<std::vector<unsigned>> wins;
+  // Names the agents gave, their commands until they do
+  std::vector<std::string> names;
+  unsigned games;
+  unsigned unfinished;
+};
+
+// A sequential test of the first agent against the second
+struct Sprt {
+  Sprt();
+
+  bool enabled;
+  double elo0;
+  double elo1;
+  double alpha;
+  double beta;
+  // Stops the test undecided after this many games, 0 for no limit
+  int maxGames;
+};
+
+std::vector<std::pair<size_t, size_t>> makePairings(size_t agents, bool gauntlet);
+void printCrosstable(const Crosstable &table);
+void printSprt(const Crosstable &table, const Sprt &sprt, double llr);
+std::string formatElo(double elo);
+
+int main(int argc, char **argv) {
+  // Defaults
+  bool gauntlet = false;
+  bool pin = false;
+  bool verbose = false;
+  int rounds = 1;
+  int concurrency = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  int progress = 0;
+  std::string logDir;
+  std::string openingsPath;
+  Sprt sprt;
+  // Every game is played with these options and limits
+  Common::MatchSpec base;
+  base.options.printBoard = false;
+  base.options.quiet = true;
+  base.options.diagnostics = nullptr;
+  std::vector<std::string> agents;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--gauntlet") {
+      gauntlet = true;
+    } else if (arg == "--rounds" && i + 1 < argc) {
+      rounds = Common::parseCount(argv[++i], rounds);
+    } else if (arg == "--concurrency" && i + 1 < argc) {
+      concurrency = Common::parseCount(argv[++i], concurrency);
+    } else if (arg == "--pin") {
+      pin = true;
+    } else if (arg == "--progress" && i + 1 < argc) {
+      progress = Common::parseCount(argv[++i], progress);
+    } else if (arg == "--log" && i + 1 < argc) {
+      logDir = argv[++i];
+    } else if (arg == "--openings" && i + 1 < argc) {
+      openingsPath = argv[++i];
+    } else if (arg == "--verbose") {
+      verbose = true;
+    } else if (arg == "--sprt" && i + 2 < argc) {
+      sprt.enabled = Common::parseDouble(argv[i + 1], sprt.elo0) &&
+                     Common::parseDouble(argv[i + 2], sprt.elo1);
+      i += 2;
+      if (!sprt.enabled)
+        return EXIT_FAILURE;
+    } else if (arg == "--alpha" && i + 1 < argc) {
+      if (!Common::parseDouble(argv[++i], sprt.alpha))
+        return EXIT_FAILURE;
+    } else if (arg == "--beta" && i + 1 < argc) {
+      if (!Common::parseDouble(argv[++i], sprt.beta))
+        return EXIT_FAILURE;
+    } else if (arg == "--max-games" && i + 1 < argc) {
+      sprt.maxGames = Common::parseCount(argv[++i], sprt.maxGames);
+    } else if (!Common::parseMatchOption(argc, argv, i, base)) {
+      agents.push_back(arg);
+    }
+  }
+
+  if (agents.size() < 2 || (sprt.enabled && agents.size() != 2) ||
+      !(sprt.alpha > 0.0 && sprt.alpha < 1.0) || !(sprt.beta > 0.0 && sprt.beta < 1.0)) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--gauntlet] [--rounds N] [--concurrency N] [--pin]"
+                 " [--progress N] [--log DIR] [--async-log MS] [--enforce SECONDS]"
+                 " [--clock BASE+INC] [--announce-time] [--adjudicate] [--max-plies N]"
+                 " [--allow-dupe-states] [--openings FILE]"
+                 " [--cpus LIST] [--memory MB] [--address-space MB] [--verbose]"
+                 " AGENT AGENT...\n"
+              << "       " << argv[0]
+              << " --sprt ELO0 ELO1 [--alpha A] [--beta B] [--max-games N]"
+                 " [options] CANDIDATE BASELINE\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::string> openings;
+  if (!openingsPath.empty() &&
+      !Common::readOpenings<ChineseCheckers::State>(openingsPath, openings))
+    return EXIT_FAILURE;
+
+  double lower, upper;
+  Common::sprtBounds(sprt.alpha, sprt.beta, lower, upper);
+
+  // Every pairing is played as game pairs, so each agent moves first as
+  // often as its opponent does. Both games of a pair start from the same
+  // opening, the same one for every pairing in a round
+  Common::Server<ChineseCheckers::State, ChineseCheckers::Client> server(
+      static_cast<size_t>(concurrency), pin);
+  std::vector<std::pair<size_t, size_t>> games;
+  auto addPair = [&](const std::pair<size_t, size_t> &pairing, size_t round) {
+    for (const auto &game : {pairing, std::make_pair(pairing.second, pairing.first)}) {
+      Common::MatchSpec spec = base;
+      spec.commands = {{agents[game.first], agents[game.second]}};
+      if (!openings.empty())
+        spec.options.startState = openings[round % openings.size()];
+      spec.agents.discardErrors = !verbose;
+      if (!logDir.empty()) {
+        spec.options.logGame = true;
+        spec.options.logPath = logDir + "/game-" + std::to_string(games.size()) + ".txt";
+      }
+      server.add(spec);
+      games.push_back(game);
+    }
+  };
+
+  // A sequential test keeps enough game pairs queued to fill every slot
+  // until it is decided, the others queue every game up front
+  auto topUp = [&](unsigned finished) {
+    while (games.size() - finished < 2 * static_cast<size_t>(concurrency) &&
+           (sprt.maxGames == 0 || games.size() < static_cast<size_t>(sprt.maxGames)))
+      addPair(std::make_pair(0, 1), games.size() / 2);
+  };
+
+  if (sprt.enabled) {
+    topUp(0);
+    std::cout << "Testing Elo " << sprt.elo0 << " against " << sprt.elo1
+              << " with alpha " << sprt.alpha << " and beta " << sprt.beta
+              << ", " << concurrency << " games at a time" << std::endl;
+  } else {
+    auto pairings = makePairings(agents.size(), gauntlet);
+    for (int round = 0; round < rounds; ++round) {
+      for (const auto &pairing : pairings)
+        addPair(pairing, static_cast<size_t>(round));
+    }
+    std::cout << "Playing " << games.size() << " games, " << concurrency
+              << " at a time" << std::endl;
+  }
+
+  Crosstable table(agents.size());
+  table.names = agents;
+  double llr = 0.0;
+  bool ok = server.run([&](size_t game, const Common::MatchResult &result) {
+    std::array<size_t, 2> players{{games[game].first, games[game].second}};
+    ++table.games;
+
+    std::cout << "Game " << game << ": ";
+    if (result.winner < 0) {
+      ++table.unfinished;
+      std::cout << "no result. " << result.error << std::endl;
+    } else {
+      unsigned winner = static_cast<unsigned>(result.winner);
+      ++table.wins[players[winner]][players[1 - winner]];
+      for (unsigned i = 0; i < 2; ++i)
+        table.names[players[i]] = result.names[i];
+      std::cout << result.names[winner] << " beats " << result.names[1 - winner]
+                << " in " << result.moves << " moves" << std::endl;
+    }
+
+    if (sprt.enabled) {
+      llr = Common::sprtLLR(table.wins[0][1], 0, table.wins[1][0], sprt.elo0,
+                            sprt.elo1);
+      printSprt(table, sprt, llr);
+      if (llr <= lower || llr >= upper)
+        server.stop();
+      else
+        topUp(table.games);
+    } else if (progress > 0 && table.games % static_cast<unsigned>(progress) == 0 &&
+               table.games < games.size()) {
+      printCrosstable(table);
+    }
+  });
+
+  printCrosstable(table);
+  if (!sprt.enabled)
+    return ok && table.unfinished == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  std::cout << "SPRT: ";
+  if (llr >= upper)
+    std::cout << "H1 accepted, " << table.names[0] << " gains at least "
+              << sprt.elo1 << " Elo" << std::endl;
+  else if (llr <= lower)
+    std::cout << "H0 accepted, " << table.names[0] << " gains at most "
+              << sprt.elo0 << " Elo" << std::endl;
+  else
+    std::cout << "inconclusive" << std::endl;
+  return ok && (llr <= lower || llr >= upper) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+Sprt::Sprt()
+    : enabled(false), elo0(0.0), elo1(5.0), alpha(0.05), beta(0.05), maxGames(0) {}
+
+Crosstable::Crosstable(size_t agents)
+    : wins(agents, std::vector<unsigned>(agents, 0)), names(agents), games(0),
+      unfinished(0) {}
+
+std::vector<std::pair<size_t, size_t>> makePairings(size_t agents, bool gauntlet) {
+  // A gauntlet plays the first agent against each of the others
+  std::vector<std::pair<size_t, size_t>> pairings;
+  for (size_t i = 0; i < (gauntlet ? 1 : agents); ++i) {
+    for (size_t j = i + 1; j < agents; ++j)
+      pairings.emplace_back(i, j);
+  }
+  return pairings;
+}
+
+void printCrosstable(const Crosstable &table) {
+  size_t agents = table.names.size();
+
+  // Each agent's record against the whole field
+  std::vector<unsigned> won(agents, 0), lost(agents, 0);
+  for (size_t i = 0; i < agents; ++i) {
+    for (size_t j = 0; j < agents; ++j) {
+      won[i] += table.wins[i][j];
+      lost[i] += table.wins[j][i];
+    }
+  }
+
+  std::vector<size_t> order(agents);
+  for (size_t i = 0; i < agents; ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+    return won[lhs] * (won[rhs] + lost[rhs]) > won[rhs] * (won[lhs] + lost[lhs]);
+  });
+
+  size_t width = 4;
+  for (const auto &name : table.names)
+    width = std::max(width, name.size());
+
+  std::cout << "\n" << std::left << std::setw(4) << "#" << std::setw(static_cast<int>(width + 2))
+            << "Name" << std::right << std::setw(8) << "Elo" << std::setw(8) << "+/-"
+            << std::setw(8) << "Games" << std::setw(8) << "Score";
+  for (size_t i = 0; i < agents; ++i)
+    std::cout << std::setw(9) << i + 1;
+  std::cout << "\n";
+
+  for (size_t rank = 0; rank < agents; ++rank) {
+    size_t i = order[rank];
+    unsigned played = won[i] + lost[i];
+    auto estimate = Common::estimateElo(won[i], 0, lost[i]);
+
+    std::stringstream score;
+    if (played > 0)
+      score << std::fixed << std::setprecision(1)
+            << 100.0 * won[i] / played << "%";
+    else
+      score << "-";
+
+    std::cout << std::left << std::setw(4) << rank + 1
+              << std::setw(static_cast<int>(width + 2)) << table.names[i] << std::right
+              << std::setw(8) << (played > 0 ? formatElo(estimate.elo) : "-")
+              << std::setw(8) << (played > 0 ? formatElo(estimate.error) : "-")
+              << std::setw(8) << played << std::setw(8) << score.str();
+
+    // Columns follow the ranking, as W-L from this row's side
+    for (size_t col = 0; col < agents; ++col) {
+      size_t j = order[col];
+      std::stringstream cell;
+      if (i == j)
+        cell << "-";
+      else
+        cell << table.wins[i][j] << "-" << table.wins[j][i];
+      std::cout << std::setw(9) << cell.str();
+    }
+    std::cout << "\n";
+  }
+
+  std::cout << table.games << " games played, " << table.unfinished
+            << " without a result" << std::endl;
+}
+
+void printSprt(const Crosstable &table, const Sprt &sprt, double llr) {
+  double lower, upper;
+  Common::sprtBounds(sprt.alpha, sprt.beta, lower, upper);
+
+  unsigned wins = table.wins[0][1];
+  unsigned losses = table.wins[1][0];
+  auto estimate = Common::estimateElo(wins, 0, losses);
+
+  std::cout << "  W-L-D " << wins << "-" << losses << "-0, Elo "
+            << formatElo(estimate.elo) << " +/- " << formatElo(estimate.error)
+            << ", LLR " << std::fixed << std::setprecision(2) << llr << " ["
+            << lower << ", " << upper << "]" << std::defaultfloat << std::endl;
+}
+
+std::string formatElo(double elo) {
+  if (std::isinf(elo))
+    return elo > 0 ? "inf" : "-inf";
+
+  std::stringstream out;
+  out << std::fixed << std::setprecision(0) << elo;
+  return out.str();
+}
@@ -7,20 +7,50 @@
 #ifndef CHINESECHECKERS_CLIENT_H_INCLUDED
 #define CHINESECHECKERS_CLIENT_H_INCLUDED
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "ChineseCheckers/OpeningBook.h"
 #include "ChineseCheckers/State.h"
+#include "Common/Format.h"
+#include "Common/String.h"
 
 namespace ChineseCheckers {
 class Client {
 public:
   static std::string startGameMessage(const std::string &player1,
                                       const std::string &player2);
-  static bool isValidStartGameMessage(const std::vector<std::string> &tokens);
-  static bool isValidMoveMessage(const std::vector<std::string> &tokens);
+  static bool isValidStartGameMessage(const Common::Tokens &tokens);
+  static bool isValidMoveMessage(const Common::Tokens &tokens);
   static std::string moveMessage(Move m);
+  // Sent before the start message to start from state rather than the
+  // usual start
+  static std::string loadStateMessage(const std::string &state);
+
+  // The messages above appended to out, returning what was appended, for
+  // callers that send them often
+  static Common::StringRef startGameMessage(Common::StringRef player1,
+                                            Common::StringRef player2,
+                                            Common::FormatBuffer &out);
+  static Common::StringRef moveMessage(Move m, Common::FormatBuffer &out);
+
+  // Binary frames, for agents that asked for them with protocolMessage. A
+  // frame starts with its type byte, which fixes its size. A move frame
+  // holds the from and to cells, a state frame the player to move and the
+  // board as State::writePacked stores them, and a DUMPSTATE frame nothing
+  enum FrameType : char { MoveFrame = 1, StateFrame = 2, DumpStateFrame = 3 };
+  static const char *const protocolMessage;
+  // Size of a frame starting with type, 0 if none does
+  static size_t frameSize(char type);
+  static std::string moveFrame(Move m);
+  static bool readMoveFrame(Common::StringRef frame, Move &m);
+  static std::string stateFrame(const State &state);
+  static bool readStateFrame(Common::StringRef frame, State &state);
+  // Stores msg as a frame, returning false if it has none and is sent as text
+  static bool messageFrame(const std::string &msg, std::string &frame);
   typedef ChineseCheckers::Move Move;
+  typedef ChineseCheckers::OpeningBook Book;
 };
 } // namespace ChineseCheckers
 #endif
@@ -0,0 +1,58 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Reads the game logs written by the Chinese Checkers moderator
+///
+//===----------------------------------------------------------------------===//
+#ifndef CHINESECHECKERS_GAMELOG_H_INCLUDED
+#define CHINESECHECKERS_GAMELOG_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/State.h"
+
+namespace ChineseCheckers {
+// A move broadcast by the moderator along with the log line it came from.
+// Malformed MOVE lines are kept as the null move {0, 0}
+struct LoggedMove {
+  Move move;
+  size_t line;
+};
+
+// Reason the moderator gave for ending a game before it was decided on the
+// board, recovered from its diagnostics. RaceAdjudicated and PlyLimit are
+// results the moderator declared rather than forfeits
+enum class Forfeit {
+  None,
+  InvalidMove,
+  TimeLimit,
+  DuplicateState,
+  RaceAdjudicated,
+  PlyLimit
+};
+
+// One game, from its BEGIN message up to the next BEGIN or the end of the log
+struct LoggedGame {
+  size_t line;
+  std::string player1;
+  std::string player2;
+  // The state sent with LOADSTATE ahead of BEGIN, empty for the usual start
+  std::string startState;
+  std::vector<LoggedMove> moves;
+
+  Forfeit forfeit;
+
+  bool hasFinal;
+  size_t finalLine;
+  std::string winner;
+  std::string loser;
+};
+
+// Appends every game found in the log text [begin, end) to games
+void parseGameLog(const char *begin, const char *end,
+                  std::vector<LoggedGame> &games);
+} // namespace ChineseCheckers
+
+#endif
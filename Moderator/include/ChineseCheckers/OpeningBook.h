@@ -0,0 +1,77 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Defines an opening book agents can consult before searching
+///
+/// Positions related by a symmetry of the board are the same game, mirrored
+/// or seen from the other side, so the book stores each one only under its
+/// canonical key. The book is a sorted binary file that is not mapped until
+/// the first probe.
+///
+//===----------------------------------------------------------------------===//
+#ifndef CHINESECHECKERS_OPENINGBOOK_H_INCLUDED
+#define CHINESECHECKERS_OPENINGBOOK_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "ChineseCheckers/PositionDB.h"
+#include "ChineseCheckers/State.h"
+#include "Common/File.h"
+
+namespace ChineseCheckers {
+// On-disk record of a book position
+struct BookEntry {
+  PositionKey key;
+  // Games the move was taken from
+  uint32_t visits;
+  uint8_t from;
+  uint8_t to;
+  uint8_t padding[2];
+};
+
+class OpeningBook {
+public:
+  OpeningBook();
+  ~OpeningBook() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  OpeningBook(const OpeningBook &) = delete;
+  // move ctor
+  OpeningBook(const OpeningBook &&) = delete;
+  // copy assignment
+  OpeningBook &operator=(const OpeningBook &) = delete;
+  // move assignment
+  OpeningBook &operator=(const OpeningBook &&) = delete;
+
+  // Uses the book at path. Nothing is read until the first probe
+  void open(const std::string &path);
+
+  // Looks up the book move for s, returning false if there is none. Maps the
+  // book on first use
+  bool probe(const State &s, Move &m);
+
+  // Number of positions in the book, mapping it if needed
+  size_t size();
+
+  // Writes the positions of db visited at least minVisits times that have a
+  // best move to a book at path. Returns the number of positions written, or
+  // -1 if path could not be written
+  static long build(const std::string &path, const PositionDB &db,
+                    uint32_t minVisits);
+
+private:
+  // Maps the book if that has not been tried yet, returning true if usable
+  bool load();
+
+  std::string path;
+  bool loaded;
+  Common::MappedFile file;
+  const BookEntry *entries;
+  size_t count;
+};
+} // namespace ChineseCheckers
+
+#endif
@@ -0,0 +1,143 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Defines an on-disk database of positions reached in logged games
+///
+/// The database is a file of PositionStats records sorted by key, followed by
+/// the key of every BlockSize'th record. Only that fence index is read into
+/// memory, so a lookup is a binary search over the fences and then over a
+/// single block of records, touching one or two pages of the file.
+///
+//===----------------------------------------------------------------------===//
+#ifndef CHINESECHECKERS_POSITIONDB_H_INCLUDED
+#define CHINESECHECKERS_POSITIONDB_H_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/GameLog.h"
+#include "ChineseCheckers/State.h"
+#include "Common/File.h"
+
+namespace ChineseCheckers {
+// Identifies a position: the words of the board's symmetric hash under
+// Symmetry::Identity, with the top bit of the last word set when player 2 is
+// to move
+typedef std::array<uint64_t, PerfectHash::NumElts> PositionKey;
+
+// Returns the key of the current position of s
+PositionKey positionKey(const State &s);
+
+// Returns the key of the position reached by playing m from key
+PositionKey childKey(const PositionKey &key, Move m);
+
+// Returns the key of the position mapped by symmetry
+PositionKey transformKey(const PositionKey &key, Symmetry symmetry);
+
+// Returns the smallest key of the positions symmetric to key, storing the
+// symmetry it was found with. This matches State::getCanonicalHash
+PositionKey canonicalKey(const PositionKey &key, Symmetry &symmetry);
+
+// Loads the position identified by key into s, returning true if it is valid
+bool loadPositionKey(State &s, const PositionKey &key);
+
+// Aggregate results of the logged games that reached a position. This is
+// the on-disk record layout
+struct PositionStats {
+  PositionKey key;
+  // Games that reached the position
+  uint32_t visits;
+  // Of those, the games won by player 1 and by player 2
+  std::array<uint32_t, 2> wins;
+  // The move with the best known results for the player to move. Both are
+  // NoMove when none is known
+  uint8_t bestFrom;
+  uint8_t bestTo;
+  uint8_t padding[2];
+
+  enum { NoMove = 0xff };
+};
+
+class PositionDB {
+public:
+  PositionDB();
+  ~PositionDB() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  PositionDB(const PositionDB &) = delete;
+  // move ctor
+  PositionDB(const PositionDB &&) = delete;
+  // copy assignment
+  PositionDB &operator=(const PositionDB &) = delete;
+  // move assignment
+  PositionDB &operator=(const PositionDB &&) = delete;
+
+  // Maps the database at path, returning true if it is a valid database
+  bool open(const std::string &path);
+  void close();
+
+  // Number of positions stored
+  size_t size() const;
+
+  // The records, in key order
+  const PositionStats *begin() const;
+  const PositionStats *end() const;
+
+  // Returns the stats of the position, or nullptr if it was never reached
+  const PositionStats *find(const PositionKey &key) const;
+  const PositionStats *find(const State &s) const;
+
+  // Looks up the best known move from s, returning false if there is none
+  bool bestMove(const State &s, Move &m) const;
+
+  enum {
+    // Records per fence
+    BlockSize = 64
+  };
+
+private:
+  Common::MappedFile file;
+  const PositionStats *records;
+  size_t count;
+  std::vector<PositionKey> fences;
+};
+
+// Collects positions from logged games and writes them out as a database,
+// optionally merged with an existing one
+class PositionDBBuilder {
+public:
+  PositionDBBuilder();
+
+  // Adds every decided game in the log at path, returning false if it could
+  // not be read
+  bool addLog(const std::string &path);
+
+  // Adds the positions of a game, from its start state up to its first
+  // invalid move. Games without a FINAL naming one of their players, or with
+  // a start state that does not load, are skipped, returning false
+  bool addGame(const LoggedGame &game);
+
+  // Number of games added
+  size_t games() const;
+
+  // Writes the collected positions merged with base, which may be empty, to
+  // path. The best move of every position is recomputed from the merged
+  // results. Returns false if path could not be written
+  bool write(const std::string &path, const PositionDB &base);
+
+private:
+  // Combines repeated keys in pending
+  void reduce();
+
+  State gs;
+  std::vector<PositionStats> pending;
+  size_t reducedSize;
+  size_t gameCount;
+};
+} // namespace ChineseCheckers
+
+#endif
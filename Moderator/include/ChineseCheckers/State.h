@@ -18,6 +18,9 @@
 #include <string>
 #include <vector>
 
+#include "Common/Format.h"
+#include "Common/String.h"
+
 namespace ChineseCheckers {
 struct Move {
   unsigned from;
@@ -59,6 +62,58 @@ bool operator==(const PerfectHash &lhs, const PerfectHash &rhs);
 bool operator<(const PerfectHash &lhs, const PerfectHash &rhs);
 std::ostream &operator<<(std::ostream &out, const PerfectHash &h);
 
+// Dense rank of a position where each player has 10 pieces. Player 1's
+// cells, player 2's cells among the rest and the player to move are ranked
+// with the combinatorial number system, giving every such position a unique
+// number below 2 * C(81, 10) * C(71, 10), which needs 81 bits
+class PositionRank {
+public:
+  PositionRank();
+  PositionRank(uint64_t high, uint64_t low);
+
+  uint64_t high() const;
+  uint64_t low() const;
+
+  // Writes the rank as NumBytes little endian bytes
+  void write(uint8_t *out) const;
+
+  // Reads a rank written by write
+  static PositionRank read(const uint8_t *in);
+
+  friend bool operator==(const PositionRank &lhs, const PositionRank &rhs);
+  friend bool operator<(const PositionRank &lhs, const PositionRank &rhs);
+  friend std::ostream &operator<<(std::ostream &out, const PositionRank &r);
+
+  enum {
+    // Bytes needed to store a rank
+    NumBytes = 11
+  };
+
+private:
+  uint64_t hi;
+  uint64_t lo;
+};
+
+bool operator==(const PositionRank &lhs, const PositionRank &rhs);
+bool operator<(const PositionRank &lhs, const PositionRank &rhs);
+std::ostream &operator<<(std::ostream &out, const PositionRank &r);
+
+// The symmetries of the board. Transpose mirrors it across the diagonal
+// through both home triangles and AntiTranspose across the other diagonal,
+// while Rotate turns it 180 degrees. Rotate and AntiTranspose exchange the
+// home triangles, so they also swap the colours and the player to move. Each
+// symmetry is its own inverse
+enum class Symmetry { Identity, Transpose, Rotate, AntiTranspose };
+
+// Returns true iff s swaps the colours and the player to move
+bool swapsPlayers(Symmetry s);
+
+// Returns the cell that s maps cell to
+unsigned transformCell(unsigned cell, Symmetry s);
+
+// Returns the move that s maps m to. Transforming again by s maps it back
+Move transformMove(Move m, Symmetry s);
+
 class State {
 public:
   // Initialize with the starting state for a 2 player game
@@ -98,23 +153,97 @@ public:
   // Reset the board to the initial state
   void reset();
 
-  // Loads the state stored in the string, returning true if it is a valid state, false if not
-  bool loadState(const std::string &newState);
+  enum {
+    // Bytes written by writePacked
+    PackedBytes = 22,
+    // Characters dumpState writes at most
+    MaxDumpSize = 163
+  };
+
+  // Formats of dumpState. Tokens is the player to move and the 81 cells
+  // separated by spaces, as in DUMPSTATE. Compact is the PackedBytes bytes
+  // of writePacked as 44 hexadecimal digits
+  enum class Format { Tokens, Compact };
+
+  // Loads the state stored in the string in either format, telling them
+  // apart by length, returning true if it is a valid state, false if not.
+  // Forgets the states seen so far, and leaves the state alone if it is not valid
+  bool loadState(Common::StringRef newState);
 
   // Dump out the current state, usable with loadState
-  std::string dumpState() const;
+  std::string dumpState(Format format = Format::Tokens) const;
+
+  // Writes the state as dumpState does to out, which has room for
+  // MaxDumpSize characters, returning how many it wrote
+  size_t dumpState(char *out, Format format = Format::Tokens) const;
+
+  // Writes the player to move in a byte and then the board, four cells a
+  // byte with the first in the low bits, as PackedBytes bytes
+  void writePacked(uint8_t *out) const;
+
+  // Loads a state written by writePacked, returning false if it is not a
+  // valid state. Forgets the states seen so far as loadState does
+  bool loadPacked(const uint8_t *in);
 
   // Translates a sequence of tokens from the move format used to the local move type
-  Move translateToLocal(const std::vector<std::string> &tokens) const;
+  Move translateToLocal(const Common::Tokens &tokens) const;
 
   // Dumps a list of the possible moves
   std::string listMoves() const;
 
+  // Appends the list of listMoves to out, returning what was appended
+  Common::StringRef listMoves(Common::FormatBuffer &out) const;
+
   // Returns a perfect hash of the current state
   PerfectHash getHash() const;
 
+  // Loads the board stored in a perfect hash with player to move, returning
+  // true if it is a valid board. Forgets the states seen so far
+  bool loadHash(const PerfectHash &hash, int player);
+
+  // Returns a perfect hash of the state mapped by symmetry. Unlike getHash
+  // the player to move is included: the top bit of the last element is set
+  // when it is player 2
+  PerfectHash getSymmetricHash(Symmetry symmetry) const;
+
+  // Returns the smallest symmetric hash, which is shared by every state
+  // symmetric to this one, and stores the symmetry it was found with. A move
+  // m for the canonical state is transformMove(m, symmetry) in this one
+  PerfectHash getCanonicalHash(Symmetry &symmetry) const;
+
+  // Returns the player whose turn it is, 1 or 2
+  int getCurrentPlayer() const;
+
+  // Stores the rank of the current state in rank, returning false if either
+  // player does not have exactly 10 pieces
+  bool getRank(PositionRank &rank) const;
+
+  // Loads the state with the given rank, returning false if it is out of
+  // range. Forgets the states seen so far
+  bool loadRank(const PositionRank &rank);
+
   // Returns true iff there has been a duplicated state
   bool seenDuplicatedState() const;
+
+  // Returns the fewest single steps that would fill player's goal with their
+  // own pieces if nothing stood in the way, or -1 unless they have exactly
+  // 10 pieces
+  int raceCount(int player) const;
+
+  // Returns true iff every piece of player 1 is further along than every
+  // piece of player 2, so neither can block the other or jump the other's
+  // pieces again without moving backwards
+  bool disengaged() const;
+
+  // Returns the player sure to win if neither moves backwards, or -1 if
+  // there is none. That is the case in a disengaged position when stepping
+  // alone a player fills their goal before the other could move each of
+  // their pieces still outside theirs even once
+  int raceWinner() const;
+
+  // Returns the player with the lower race count, the player to move if
+  // both are the same
+  int raceLeader() const;
 private:
   // mutable due to how we find jump moves
   mutable std::array<int, 81> board;
@@ -0,0 +1,91 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Line based protocol I/O over raw file descriptors
+///
+/// Input is read with read(2) into a ring buffer and split into lines.
+/// Output is queued and only written when flushed, so a turn that sends
+/// several lines costs a single write. A read that has to wait flushes the
+/// output first, as the other side cannot answer what it has not seen.
+/// Binary frames can share the stream with lines once frame sizes are given.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_CHANNEL_H_INCLUDED
+#define COMMON_CHANNEL_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Common/String.h"
+
+namespace Common {
+// Size of the frame starting with the byte type, or 0 if no frame does
+typedef size_t (*FrameSize)(char type);
+
+class Channel {
+public:
+  // Reads lines from in and writes lines to out. Neither is ever closed
+  Channel(int in, int out);
+  ~Channel() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  Channel(const Channel &) = delete;
+  // move ctor
+  Channel(const Channel &&) = delete;
+  // copy assignment
+  Channel &operator=(const Channel &) = delete;
+  // move assignment
+  Channel &operator=(const Channel &&) = delete;
+
+  // Standard input and output
+  static Channel &standard();
+
+  // Reads the next line into line without its newline or trailing white
+  // space, waiting at most timeout seconds or forever if it is negative.
+  // Returns false if it gave up. At the end of input the rest of it counts
+  // as a line, and after that every read returns an empty line
+  bool readLine(std::string &line, double timeout = -1.0);
+
+  // From now on input starting with a byte frameSize gives a size for is
+  // read as a frame of that size, which readLine returns whole. Lines are
+  // read as before
+  void setFrameSize(FrameSize frameSize);
+
+  // Queues line followed by a newline. Nothing is written until flush,
+  // unless a lot is queued
+  void write(StringRef line);
+
+  // Queues a frame as it is
+  void writeFrame(StringRef frame);
+
+  // Writes everything queued, returning false if it could not be
+  bool flush();
+
+private:
+  // Moves the first complete line or frame out of the ring to line. Once
+  // input has ended whatever is left counts as a line
+  bool takeLine(std::string &line);
+
+  // Copies length bytes from head out of the ring to line
+  void copyOut(std::string &line, size_t length) const;
+
+  // Reads whatever is available into the ring, growing it if it is full
+  void fill();
+
+  int in;
+  int out;
+  // Holds input from head up to tail, both counted from the start of input
+  std::vector<char> ring;
+  size_t head;
+  size_t tail;
+  // Where the search for the next newline resumes
+  size_t scanned;
+  bool ended;
+  FrameSize frameSize;
+  std::string outbox;
+};
+} // namespace Common
+
+#endif
@@ -10,9 +10,32 @@
 #include <string>
 #include <vector>
 
+#include "Common/Channel.h"
+#include "Common/String.h"
+
 namespace Common {
-/// Reads a line, up to a newline from the server
+/// Reads a line, up to a newline from the server. Returns an empty line at
+/// the end of input
 std::string readMsg();
+
+/// Reads a line like readMsg, giving up if none is complete within timeout
+/// seconds. Returns false if it gave up. Mixing std::cin with these loses
+/// whatever they have read ahead
+bool readMsg(std::string &msg, double timeout);
+
+/// Queues a line for the server. Queued lines are sent by flushMsgs, or
+/// before readMsg waits for an answer. Mixing std::cout with these can
+/// reorder lines
+void sendMsg(StringRef msg);
+
+/// Queues a binary frame for the server, sent with the lines
+void sendFrame(StringRef frame);
+
+/// Sends every queued line. Call where the turn passes to the other side
+void flushMsgs();
+
+/// Makes readMsg return binary frames whole, see Channel::setFrameSize
+void readFrames(FrameSize frameSize);
 } // namespace Common
 
 #endif
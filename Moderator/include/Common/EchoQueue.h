@@ -0,0 +1,67 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief The broadcasts a relay has yet to echo back, oldest first
+///
+/// A relay echoes every broadcast back in the order it was sent, so only the
+/// oldest pending echo can be the next one to arrive. Each is kept as the
+/// hash and length of its text and where the text starts in an arena, so an
+/// arriving message is checked against it in constant time. Identical
+/// broadcasts are pending once each, and the arena and queue are reused
+/// once every echo has arrived, so nothing is allocated in the long run.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_ECHOQUEUE_H_INCLUDED
+#define COMMON_ECHOQUEUE_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Common/String.h"
+
+namespace Common {
+class EchoQueue {
+public:
+  EchoQueue();
+  ~EchoQueue() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  EchoQueue(const EchoQueue &) = delete;
+  // move ctor
+  EchoQueue(const EchoQueue &&) = delete;
+  // copy assignment
+  EchoQueue &operator=(const EchoQueue &) = delete;
+  // move assignment
+  EchoQueue &operator=(const EchoQueue &&) = delete;
+
+  // Expects msg to be echoed after everything already pending
+  void push(StringRef msg);
+
+  // Returns true and stops expecting the oldest pending echo if msg is it
+  bool pop(StringRef msg);
+
+  bool empty() const { return head == pending.size(); }
+  size_t size() const { return pending.size() - head; }
+  void clear();
+
+private:
+  struct Echo {
+    uint64_t hash;
+    size_t length;
+    size_t offset;
+  };
+
+  static uint64_t hash(StringRef msg);
+
+  std::vector<Echo> pending;
+  // Index in pending of the oldest echo still expected
+  size_t head;
+  // The text of everything in pending
+  std::string arena;
+};
+} // namespace Common
+
+#endif
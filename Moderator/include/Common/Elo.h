@@ -0,0 +1,43 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Defines routines for estimating rating differences from results
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_ELO_H_INCLUDED
+#define COMMON_ELO_H_INCLUDED
+
+namespace Common {
+/// Returns the Elo difference at which a player is expected to score score,
+/// a fraction strictly between 0 and 1
+double eloFromScore(double score);
+
+/// Returns the expected score of a player elo points stronger
+double scoreFromElo(double elo);
+
+/// An Elo difference with the half width of its 95% confidence interval
+struct EloEstimate {
+  double elo;
+  double error;
+};
+
+/// Estimates the Elo difference behind a record of wins, draws and losses.
+/// The interval comes from the normal approximation of the mean score. A
+/// record with no wins or no losses gives an infinite difference and error
+EloEstimate estimateElo(unsigned wins, unsigned draws, unsigned losses);
+
+/// Returns the log likelihood ratio of the Elo difference being elo1 rather
+/// than elo0 given a record, by the normal approximation of the generalized
+/// SPRT. Half a win and half a loss are added to the record, so that one
+/// with only wins or only losses still has a variance. Returns 0 before any
+/// games are played
+double sprtLLR(unsigned wins, unsigned draws, unsigned losses, double elo0,
+               double elo1);
+
+/// Sets the bounds of a sequential probability ratio test with false
+/// positive rate alpha and false negative rate beta. The test accepts elo0
+/// once the LLR falls to lower and elo1 once it reaches upper
+void sprtBounds(double alpha, double beta, double &lower, double &upper);
+} // namespace Common
+
+#endif
@@ -0,0 +1,56 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Defines routines for reading files and directories from disk
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_FILE_H_INCLUDED
+#define COMMON_FILE_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Common {
+/// A read-only memory mapping of an entire file
+class MappedFile {
+public:
+  // How the mapping will be read, passed on to the kernel's readahead
+  enum class Access { Sequential, Random };
+
+  MappedFile();
+  ~MappedFile();
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  MappedFile(const MappedFile &) = delete;
+  // move ctor
+  MappedFile(const MappedFile &&) = delete;
+  // copy assignment
+  MappedFile &operator=(const MappedFile &) = delete;
+  // move assignment
+  MappedFile &operator=(const MappedFile &&) = delete;
+
+  // Maps the file at path, returning true if it could be opened and mapped
+  bool open(const std::string &path, Access access = Access::Sequential);
+
+  // Unmaps the file, if one is mapped
+  void close();
+
+  // The mapped bytes. An empty file maps to an empty range
+  const char *begin() const;
+  const char *end() const;
+  size_t size() const;
+
+private:
+  int fd;
+  void *data;
+  size_t length;
+};
+
+/// Appends the paths of the regular files in directory to files, sorted by
+/// name. Returns false if the directory could not be read
+bool listFiles(const std::string &directory, std::vector<std::string> &files);
+} // namespace Common
+
+#endif
@@ -0,0 +1,75 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Formats protocol text into a buffer the caller provides
+///
+/// Numbers are written digit by digit as std::to_chars would, without the
+/// locale lookups and allocations of a std::stringstream. The buffer is
+/// usually an array on the caller's stack. Text that outgrows it moves to
+/// the heap, so nothing is ever cut off.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_FORMAT_H_INCLUDED
+#define COMMON_FORMAT_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+#include "Common/String.h"
+
+namespace Common {
+class FormatBuffer {
+public:
+  FormatBuffer(char *buffer, size_t capacity);
+  template <size_t N>
+  explicit FormatBuffer(char (&buffer)[N]) : FormatBuffer(buffer, N) {}
+
+  // dtor - default since the buffer belongs to the caller
+  ~FormatBuffer() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  FormatBuffer(const FormatBuffer &) = delete;
+  // move ctor
+  FormatBuffer(const FormatBuffer &&) = delete;
+  // copy assignment
+  FormatBuffer &operator=(const FormatBuffer &) = delete;
+  // move assignment
+  FormatBuffer &operator=(const FormatBuffer &&) = delete;
+
+  FormatBuffer &operator<<(StringRef text);
+  FormatBuffer &operator<<(char c);
+  FormatBuffer &operator<<(int value);
+  FormatBuffer &operator<<(unsigned value);
+  FormatBuffer &operator<<(long value);
+  FormatBuffer &operator<<(unsigned long value);
+  FormatBuffer &operator<<(long long value);
+  FormatBuffer &operator<<(unsigned long long value);
+  // Six significant digits, as a std::ostream writes doubles by default
+  FormatBuffer &operator<<(double value);
+
+  // Writes value right aligned in width characters, as std::setw does
+  FormatBuffer &padded(long long value, unsigned width);
+  // Writes value with precision digits after the point, as std::fixed does
+  FormatBuffer &fixed(double value, int precision);
+
+  // The text written so far, until more is written or the buffer is gone
+  StringRef str() const { return StringRef(start, static_cast<size_t>(next - start)); }
+  size_t size() const { return static_cast<size_t>(next - start); }
+  void clear() { next = start; }
+
+private:
+  // Makes room for more characters after next
+  void reserve(size_t more);
+  FormatBuffer &writeSigned(long long value);
+  FormatBuffer &writeUnsigned(unsigned long long value);
+
+  char *start;
+  char *next;
+  char *limit;
+  // Holds the text once it outgrows the caller's buffer
+  std::string spill;
+};
+} // namespace Common
+
+#endif
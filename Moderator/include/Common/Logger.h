@@ -0,0 +1,74 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Writes lines to a stream from a background thread
+///
+/// Lines are copied into a lock-free ring buffer with a single producer and
+/// a single consumer. The background thread wakes up every flush interval
+/// and writes everything queued to the stream in one go, so the thread that
+/// logs never waits on the disk or the terminal. It only waits when the ring
+/// is full, for the background thread to make room, and nothing is dropped.
+/// Everything queued is written and flushed before the destructor returns,
+/// which wakes the background thread rather than waiting for it.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_LOGGER_H_INCLUDED
+#define COMMON_LOGGER_H_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "Common/String.h"
+
+namespace Common {
+class Logger {
+public:
+  // Writes to out, which only the background thread may touch until the
+  // logger is destroyed, every flushInterval seconds but at most every
+  // millisecond. The ring holds at least capacity bytes
+  Logger(std::ostream &out, double flushInterval, size_t capacity = 1 << 20);
+  ~Logger();
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  Logger(const Logger &) = delete;
+  // move ctor
+  Logger(const Logger &&) = delete;
+  // copy assignment
+  Logger &operator=(const Logger &) = delete;
+  // move assignment
+  Logger &operator=(const Logger &&) = delete;
+
+  // Queues text as it is. Only one thread may queue
+  void append(StringRef text);
+
+  // Queues line followed by a newline
+  void write(StringRef line);
+
+private:
+  // Writes whatever is queued, returning false if there was nothing
+  bool drain();
+  void run();
+
+  std::ostream &out;
+  std::chrono::duration<double> interval;
+  std::vector<char> ring;
+  // Counted from the start of the output. Only the background thread moves
+  // head and only the logging thread moves tail
+  std::atomic<size_t> head;
+  std::atomic<size_t> tail;
+  // Only taken to stop the background thread
+  std::mutex stopMutex;
+  std::condition_variable stopped;
+  bool stopping;
+  std::thread writer;
+};
+} // namespace Common
+
+#endif
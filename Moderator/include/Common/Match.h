@@ -0,0 +1,557 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Hosts a game between two agent processes without the GameMaster
+///
+/// The match runs both agents itself and answers the GameMaster commands they
+/// use (#name, #players, #getname and #quit) natively. Ids follow the
+/// GameMaster's numbering: 0 is the moderator and 1 and 2 are the players.
+/// Everything the moderator broadcasts, including the move just played, is
+/// sent to both agents, so agents see the same traffic as through the relay.
+/// An agent that sends GameClient::protocolMessage before the game begins is
+/// answered with it and from then on gets and may send binary frames, see
+/// GameClient::frameSize, wherever GameClient has one for a message.
+/// The match itself never blocks: either the caller waits for its file
+/// descriptors and calls readable or writable, or play runs the whole game.
+/// When the time limit is enforced or clocks are in use a caller waits no
+/// longer than timeLeft and then calls enforceDeadline, so an agent that
+/// hangs loses on time. The wall and CPU time of every move is reported as
+/// a CPU diagnostic after the moderator's MOVE diagnostic, and totalled in
+/// the result. So is each agent's peak memory, and an agent whose peak
+/// passes the spec's memory limit forfeits.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_MATCH_H_INCLUDED
+#define COMMON_MATCH_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "Common/Format.h"
+#include "Common/Moderator.h"
+#include "Common/Profile.h"
+#include "Common/Process.h"
+#include "Common/String.h"
+#include "Common/Timer.h"
+
+namespace Common {
+// A game for a match to host
+struct MatchSpec {
+  // Command lines of player 1 and player 2
+  std::array<std::string, 2> commands;
+  ModeratorOptions options;
+  // How both agents are run
+  ProcessOptions agents;
+  // Bytes an agent may have resident at its peak, checked after every move.
+  // Unlimited if 0
+  size_t memoryLimit = 0;
+};
+
+// How a match ended
+struct MatchResult {
+  // The names the agents gave, or their commands if they never did
+  std::array<std::string, 2> names;
+  // The player who won, 0 or 1, or -1 if there was no result
+  int winner;
+  int moves;
+  // Moves made by each player, which need not alternate from player 1 when
+  // the game starts from a loaded state
+  std::array<int, 2> playerMoves;
+  // Why there was no result, empty if there was one
+  std::string error;
+  // Seconds each player spent on their own moves
+  std::array<double, 2> moveWallTime;
+  // CPU seconds each player used during their own moves, and over the whole
+  // game including the opponent's turns. -1 where CPU time is unknown
+  std::array<double, 2> moveCpuTime;
+  std::array<double, 2> gameCpuTime;
+  // Bytes each player had resident at its peak, -1 if unknown
+  std::array<long long, 2> peakMemory;
+};
+
+template <typename GameState, typename GameClient>
+class Match {
+public:
+  Match();
+  ~Match() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  Match(const Match &) = delete;
+  // move ctor
+  Match(const Match &&) = delete;
+  // copy assignment
+  Match &operator=(const Match &) = delete;
+  // move assignment
+  Match &operator=(const Match &&) = delete;
+
+  // Starts both agents. Returns false, with the reason in the result, if
+  // either could not be started
+  bool start(const MatchSpec &spec);
+
+  // Write to and read from player 0 or 1
+  int input(unsigned player) const;
+  int output(unsigned player) const;
+
+  // Reads what player has sent and handles any complete lines
+  void readable(unsigned player);
+
+  // Sends player what could not be written before
+  void writable(unsigned player);
+
+  // Returns the seconds until an agent runs out of time, either to move or
+  // to name itself before the game begins. Agents have the move time limit
+  // to name themselves, or the starting clock time when only clocks are in
+  // use. Infinity if there is no limit
+  double timeLeft() const;
+
+  // Ends the game against an agent that has run out of time
+  void enforceDeadline();
+
+  // Returns true once the game is decided or cannot be played
+  bool finished() const;
+
+  // Plays the whole game, waiting on the agents with poll, then stops them.
+  // Ignores SIGPIPE so a dead agent cannot take this process with it
+  void play();
+
+  // Kills the agents
+  void stop();
+
+  MatchResult result() const;
+
+private:
+  void handleLine(unsigned player, const std::string &line);
+  void handleFrame(unsigned player, const std::string &frame);
+  // Sends a broadcast of the moderator to both players
+  void broadcast(const std::string &msg);
+  // Starts timing the turn of player
+  void startTurn(unsigned player);
+  // Accounts for the move player just made
+  void recordMove(unsigned player);
+  // Samples the peak memory of both players
+  void sampleMemory();
+  static std::string formatMegabytes(long long bytes);
+  // Appends what formatMegabytes returns to out
+  static void formatMegabytes(long long bytes, Common::FormatBuffer &out);
+  void send(unsigned player, const std::string &msg);
+  void sendFrame(unsigned player, const std::string &frame);
+  void flush(unsigned player);
+  void fail(const std::string &why);
+
+  Moderator<GameState, GameClient> moderator;
+  ModeratorOptions options;
+  std::array<Process, 2> agents;
+  std::array<std::string, 2> names;
+  std::array<std::string, 2> inbox;
+  std::array<std::string, 2> outbox;
+  std::array<bool, 2> named;
+  // Whether each player speaks in binary frames
+  std::array<bool, 2> binary;
+  bool started;
+  std::chrono::steady_clock::time_point launched;
+  std::chrono::steady_clock::time_point turnStarted;
+  std::array<double, 2> turnCpuStart;
+  std::array<int, 2> playerMoves;
+  std::array<double, 2> moveWallTime;
+  std::array<double, 2> moveCpuTime;
+  size_t memoryLimit;
+  std::array<long long, 2> peakMemory;
+  // Reused for every command an agent sends
+  Common::Tokens lineTokens;
+  std::string error;
+};
+} // namespace Common
+
+// Implementation
+//------------------------------------------------------------------------------
+
+namespace Common {
+template <typename GameState, typename GameClient>
+Match<GameState, GameClient>::Match()
+    : named{{false, false}}, binary{{false, false}}, started(false), turnCpuStart{{0.0, 0.0}},
+      playerMoves{{0, 0}}, moveWallTime{{0.0, 0.0}}, moveCpuTime{{0.0, 0.0}}, memoryLimit(0),
+      peakMemory{{-1, -1}} {}
+
+template <typename GameState, typename GameClient>
+bool Match<GameState, GameClient>::start(const MatchSpec &spec) {
+  options = spec.options;
+  names = spec.commands;
+  memoryLimit = spec.memoryLimit;
+  launched = std::chrono::steady_clock::now();
+
+  for (unsigned i = 0; i < agents.size(); ++i) {
+    if (!agents[i].start(splitCommand(spec.commands[i]), spec.agents)) {
+      fail("Could not run '" + spec.commands[i] + "'");
+      stop();
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename GameState, typename GameClient>
+int Match<GameState, GameClient>::input(unsigned player) const {
+  return agents[player].input();
+}
+
+template <typename GameState, typename GameClient>
+int Match<GameState, GameClient>::output(unsigned player) const {
+  return agents[player].output();
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::readable(unsigned player) {
+  char buffer[4096];
+  ssize_t got;
+  {
+    PROFILE_ZONE(Read);
+    got = read(agents[player].output(), buffer, sizeof(buffer));
+  }
+  if (got < 0 && (errno == EAGAIN || errno == EINTR))
+    return;
+
+  if (got <= 0) {
+    if (!started)
+      fail(names[player] + " exited before the game began");
+    else
+      moderator.forfeit(player, "Exited");
+    return;
+  }
+
+  std::string &pending = inbox[player];
+  pending.append(buffer, static_cast<size_t>(got));
+
+  while (!finished() && !pending.empty()) {
+    size_t frameSize = binary[player] ? GameClient::frameSize(pending[0]) : 0;
+    if (frameSize > 0) {
+      if (pending.size() < frameSize)
+        break;
+      std::string frame = pending.substr(0, frameSize);
+      pending.erase(0, frameSize);
+      handleFrame(player, frame);
+      continue;
+    }
+
+    size_t lineEnd = pending.find('\n');
+    if (lineEnd == std::string::npos)
+      break;
+    std::string line = pending.substr(0, lineEnd);
+    pending.erase(0, lineEnd + 1);
+    handleLine(player, Common::rtrim(line));
+  }
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::writable(unsigned player) {
+  flush(player);
+}
+
+template <typename GameState, typename GameClient>
+double Match<GameState, GameClient>::timeLeft() const {
+  if (finished())
+    return std::numeric_limits<double>::infinity();
+  if (started)
+    return moderator.timeLeft();
+
+  double limit;
+  if (options.enforceTimeLimit)
+    limit = options.turnTimeLimit;
+  else if (options.clockBase > 0.0)
+    limit = options.clockBase;
+  else
+    return std::numeric_limits<double>::infinity();
+
+  std::chrono::duration<double> waited = std::chrono::steady_clock::now() - launched;
+  return limit - waited.count();
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::enforceDeadline() {
+  if (finished() || timeLeft() > 0.0)
+    return;
+
+  if (started) {
+    moderator.enforceDeadline();
+    return;
+  }
+
+  unsigned late = named[0] ? 1 : 0;
+  fail(names[late] + " did not name itself within the time limit");
+}
+
+template <typename GameState, typename GameClient>
+bool Match<GameState, GameClient>::finished() const {
+  return !error.empty() || moderator.finished();
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::play() {
+  std::signal(SIGPIPE, SIG_IGN);
+
+  while (!finished()) {
+    // Only wait to write when something is queued, poll skips negative fds
+    std::array<pollfd, 4> fds;
+    for (unsigned player = 0; player < 2; ++player) {
+      fds[2 * player] = pollfd{output(player), POLLIN, 0};
+      fds[2 * player + 1] =
+          pollfd{outbox[player].empty() ? -1 : input(player), POLLOUT, 0};
+    }
+
+    int ready = poll(fds.data(), fds.size(), Common::pollTimeout(timeLeft()));
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      fail("Could not wait for the agents");
+      break;
+    }
+
+    enforceDeadline();
+
+    for (unsigned player = 0; player < 2 && !finished(); ++player) {
+      if (fds[2 * player + 1].revents != 0)
+        writable(player);
+      if (fds[2 * player].revents != 0)
+        readable(player);
+    }
+  }
+
+  stop();
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::stop() {
+  // Peaks are gone with the processes
+  sampleMemory();
+  for (auto &agent : agents)
+    agent.stop();
+}
+
+template <typename GameState, typename GameClient>
+MatchResult Match<GameState, GameClient>::result() const {
+  MatchResult r;
+  r.names = names;
+  r.winner = error.empty() ? moderator.winner() : -1;
+  r.moves = moderator.moves();
+  r.playerMoves = playerMoves;
+  r.error = error;
+  r.moveWallTime = moveWallTime;
+  r.moveCpuTime = moveCpuTime;
+  r.peakMemory = peakMemory;
+  for (unsigned player = 0; player < 2; ++player)
+    r.gameCpuTime[player] = agents[player].cpuTime();
+  return r;
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::handleLine(unsigned player,
+                                              const std::string &line) {
+  if (line.empty() || line[0] != '#') {
+    // Nothing is played before BEGIN
+    if (!started)
+      return;
+
+    int moves = moderator.moves();
+    moderator.handleMessage(player, line);
+    if (moderator.moves() > moves)
+      recordMove(player);
+    return;
+  }
+
+  // GameMaster commands
+  Common::Tokens &tokens = lineTokens;
+  Common::tokenize(line, tokens);
+  if (tokens[0] == "#name") {
+    if (started || line.length() < 7)
+      return;
+
+    names[player] = line.substr(6);
+    named[player] = true;
+    if (!named[0] || !named[1])
+      return;
+
+    started = true;
+    bool ok = moderator.begin(options, names[0], names[1],
+                              [this](const std::string &msg) { broadcast(msg); });
+    if (!ok && names[0] == names[1])
+      fail("Both agents are named " + names[0]);
+    else if (!ok)
+      fail("Cannot start from state " + options.startState);
+    startTurn(moderator.playerToMove());
+  } else if (tokens[0] == "#protocol") {
+    // Protocols only change before the game, unknown ones are not answered
+    if (!started && line == GameClient::protocolMessage) {
+      binary[player] = true;
+      send(player, GameClient::protocolMessage);
+    }
+  } else if (tokens[0] == "#players") {
+    send(player, "#players 3");
+  } else if (tokens[0] == "#getname" && tokens.size() == 2) {
+    // Malformed ones are ignored, as the GameMaster does
+    int id;
+    if (Common::parseInt(tokens[1], id) != Common::ParseError::None)
+      return;
+
+    std::string name = "null";
+    if (id == 0)
+      name = "moderator";
+    else if ((id == 1 || id == 2) && named[static_cast<unsigned>(id - 1)])
+      name = names[static_cast<unsigned>(id - 1)];
+    send(player, "#getname " + tokens[1].str() + " " + name);
+  } else if (tokens[0] == "#quit") {
+    if (!started)
+      fail(names[player] + " quit before the game began");
+    else
+      moderator.forfeit(player, "Quit");
+  }
+
+  // Anything else starting with # is a comment
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::handleFrame(unsigned player,
+                                               const std::string &frame) {
+  // Only moves are played, other frames are not for the moderator
+  typename GameClient::Move m;
+  bool move;
+  {
+    PROFILE_ZONE(Parse);
+    move = started && GameClient::readMoveFrame(frame, m);
+  }
+  if (!move)
+    return;
+
+  int moves = moderator.moves();
+  moderator.playMove(player, m);
+  if (moderator.moves() > moves)
+    recordMove(player);
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::broadcast(const std::string &msg) {
+  std::string frame;
+  bool framed = (binary[0] || binary[1]) && GameClient::messageFrame(msg, frame);
+  for (unsigned player = 0; player < 2; ++player) {
+    if (framed && binary[player])
+      sendFrame(player, frame);
+    else
+      send(player, msg);
+  }
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::startTurn(unsigned player) {
+  turnStarted = std::chrono::steady_clock::now();
+  turnCpuStart[player] = agents[player].cpuTime();
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::recordMove(unsigned player) {
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - turnStarted;
+  double cpuNow = agents[player].cpuTime();
+  double cpu = -1.0;
+  if (cpuNow >= 0.0 && turnCpuStart[player] >= 0.0 && moveCpuTime[player] >= 0.0) {
+    cpu = cpuNow - turnCpuStart[player];
+    moveCpuTime[player] += cpu;
+  } else {
+    moveCpuTime[player] = -1.0;
+  }
+  ++playerMoves[player];
+  moveWallTime[player] += wall.count();
+  sampleMemory();
+
+  char buffer[256];
+  Common::FormatBuffer msg(buffer);
+  msg << "CPU | Turn: " << moderator.moves() << " | Player " << player + 1
+      << ": " << names[player] << " | Wall: ";
+  msg.fixed(wall.count(), 3) << "s | CPU: ";
+  if (cpu >= 0.0)
+    msg.fixed(cpu, 3) << "s";
+  else
+    msg << "-";
+  msg << " | Peak memory: ";
+  formatMegabytes(peakMemory[player], msg);
+  moderator.comment(msg.str());
+
+  for (unsigned i = 0; i < 2; ++i) {
+    if (memoryLimit > 0 && peakMemory[i] > static_cast<long long>(memoryLimit))
+      moderator.forfeit(i, "Memory. Peak of " + formatMegabytes(peakMemory[i]) +
+                               " exceeds the limit of " +
+                               formatMegabytes(static_cast<long long>(memoryLimit)));
+  }
+
+  startTurn(1 - player);
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::sampleMemory() {
+  for (unsigned player = 0; player < 2; ++player)
+    peakMemory[player] = std::max(peakMemory[player], agents[player].peakMemory());
+}
+
+template <typename GameState, typename GameClient>
+std::string Match<GameState, GameClient>::formatMegabytes(long long bytes) {
+  char buffer[64];
+  Common::FormatBuffer out(buffer);
+  formatMegabytes(bytes, out);
+  return out.str().str();
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::formatMegabytes(long long bytes,
+                                                   Common::FormatBuffer &out) {
+  if (bytes < 0)
+    out << "-";
+  else
+    out.fixed(static_cast<double>(bytes) / (1024 * 1024), 1) << " MB";
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::send(unsigned player, const std::string &msg) {
+  outbox[player] += msg;
+  outbox[player] += '\n';
+  flush(player);
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::sendFrame(unsigned player,
+                                             const std::string &frame) {
+  outbox[player] += frame;
+  flush(player);
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::flush(unsigned player) {
+  std::string &pending = outbox[player];
+  while (!pending.empty()) {
+    ssize_t wrote = write(agents[player].input(), pending.data(), pending.size());
+    if (wrote < 0) {
+      if (errno == EINTR)
+        continue;
+      // Wait for the agent to read, or drop what a dead agent will never read
+      if (errno != EAGAIN)
+        pending.clear();
+      return;
+    }
+    pending.erase(0, static_cast<size_t>(wrote));
+  }
+}
+
+template <typename GameState, typename GameClient>
+void Match<GameState, GameClient>::fail(const std::string &why) {
+  if (error.empty())
+    error = why;
+}
+} // namespace Common
+
+#endif
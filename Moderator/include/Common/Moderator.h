@@ -3,24 +3,95 @@
 /// \file
 /// \brief Creates a basic moderator for a game
 ///
+/// A game can be relayed through the GameMaster over standard input and
+/// output with playGame, or hosted by a caller that talks to the players itself:
+/// begin starts the game, handleMessage feeds it each line a player sends, or
+/// playMove each move a host has decoded itself, and the broadcasts are
+/// handed to an Output callback.
+///
 //===----------------------------------------------------------------------===//
 #ifndef COMMON_MODERATOR_H_INCLUDED
 #define COMMON_MODERATOR_H_INCLUDED
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
 #include <fstream>
-#include <set>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "Common/Client.h"
+#include "Common/EchoQueue.h"
+#include "Common/Format.h"
+#include "Common/Logger.h"
+#include "Common/Profile.h"
 #include "Common/String.h"
 #include "Common/Timer.h"
 
 namespace Common {
+// How a moderator runs a game
+struct ModeratorOptions {
+  // Report the board after every move as a diagnostic, for the GUI
+  bool printBoard = true;
+  // Report only the cells that changed since the last board, see printGUIInfo
+  bool guiDeltas = false;
+  // Leave the moves of the player to move out of board reports, for GUIs
+  // that do not show them
+  bool guiMoves = true;
+  // Don't report messages that are not understood
+  bool quiet = false;
+  double turnTimeLimit = 30.0; // in seconds
+  bool enforceTimeLimit = false;
+  // Fischer clocks: each player starts with clockBase seconds and gains
+  // clockIncrement after every move they make. No clocks if clockBase is 0
+  double clockBase = 0.0;
+  double clockIncrement = 0.0;
+  // Broadcast "TIME <player 1 ms> <player 2 ms>" with both clocks before
+  // every turn. Agents that ask for this need to skip it when reading echoes
+  bool announceTime = false;
+  bool forbidDuplicateStates = true;
+  // End a game as soon as the game state can tell who wins the race to the
+  // finish, see raceWinner
+  bool adjudicateRaces = false;
+  // End a game after this many plies in favour of the game state's
+  // raceLeader. No limit if 0
+  int maxPlies = 0;
+  // Start from this state, in a format GameState::loadState reads, rather
+  // than the usual start. It is sent to the players with LOADSTATE before
+  // BEGIN, and its player to move moves first
+  std::string startState;
+  // Log the game to logPath, or to player1-vs-player2.txt if it is empty
+  bool logGame = false;
+  std::string logPath;
+  // Where diagnostics are written, nowhere if nullptr
+  std::ostream *diagnostics = &std::cerr;
+  // Write the log and diagnostics from background threads, flushing them
+  // every logFlushInterval seconds, so slow output does not count against
+  // the players' time. Written as they come if 0
+  double logFlushInterval = 0.0;
+};
+
+// Reads a suite of start states for ModeratorOptions::startState, one a line
+// in the format of LOADSTATE with or without the command itself. Blank lines
+// and lines starting with # are skipped. Returns false if the file cannot be
+// read or holds no states, with the number of the first line GameState
+// cannot start a game from in badLine, or 0 if it was the file
+template <typename GameState>
+bool readOpeningSuite(const std::string &path, std::vector<std::string> &states,
+                      size_t &badLine);
+
 template <typename GameState, typename GameClient>
 class Moderator {
 public:
+  // Receives every message broadcast to the players
+  typedef std::function<void(const std::string &msg)> Output;
+  typedef typename GameClient::Move Move;
+
   Moderator();
   ~Moderator();
 
@@ -34,28 +105,126 @@ public:
   // move assignment
   Moderator &operator=(const Moderator &&) = delete;
 
+  // Plays a game relayed through the GameMaster
+  void playGame(const ModeratorOptions &options);
   void playGame(bool printBoard, bool quiet, double turnTimeLimit,
                 bool logGame, bool enforceTimeLimit, bool forbidDuplicateStates);
 
+  // Starts a hosted game between player1 and player2, broadcasting through
+  // output. Returns false if the game cannot be played
+  bool begin(const ModeratorOptions &options, const std::string &player1,
+             const std::string &player2, Output output);
+
+  // Handles a line sent by player 0 or 1 of a hosted game
+  void handleMessage(unsigned player, const std::string &msg);
+
+  // Handles a move sent by player 0 or 1 of a hosted game in a form other
+  // than a message, such as a binary frame
+  void playMove(unsigned player, const Move &move);
+
+  // Ends the game with player losing for a reason found outside the
+  // moderator, such as the player exiting
+  void forfeit(unsigned player, const std::string &reason);
+
+  // Returns the seconds the player to move has left before they lose on
+  // time, or infinity if there is no time limit or clock or the game is over
+  double timeLeft() const;
+
+  // Forfeits the player to move if their time has run out, returning true
+  // if they did. Callers waiting on the players should wait no longer than
+  // timeLeft and call this when the wait ends
+  bool enforceDeadline();
+
+  // Reports a diagnostic the way the moderator reports its own, for hosts
+  // that measure what the moderator cannot
+  void comment(Common::StringRef msg);
+
+  // Returns true once the result has been announced
+  bool finished() const;
+
+  // The player who won, 0 or 1, or -1 if no result was announced
+  int winner() const;
+
+  // Number of moves played
+  int moves() const;
+
+  // The player whose turn it is, 0 or 1
+  unsigned playerToMove() const;
+
+  const std::string &playerName(unsigned player) const;
+
 private:
   void waitForStart();
 
+  // True for the GameMaster's notices of joining clients and its answers to
+  // #players, which can still arrive once the game has begun
+  static bool gameMasterNotice(const Common::Tokens &tokens);
+
+  // Starts timing the move of the player to move
+  void startTurn();
+
+  // Seconds the player to move has spent on this turn so far
+  double turnElapsed() const;
+
+  bool usesClock() const;
+
   // Open files for logging
   void setupLogging();
 
-  void broadcast(const std::string &msg);
-  void diagnostic(const std::string &msg);
+  void handleMove(unsigned player, const std::string &msg,
+                  const Common::Tokens &tokens);
+
+  // Ends the game against player for sending msg out of turn
+  void outOfTurn(unsigned player, Common::StringRef msg);
+
+  // Plays the move of the player to move, which they sent as msg
+  void play(const Move &m, Common::StringRef msg);
+
+  // Ends the game if it can be decided without playing it out, returning
+  // true if it was
+  bool adjudicate();
+
+  void broadcast(Common::StringRef msg);
+  void diagnostic(Common::StringRef msg);
+  // Writes msg to std::cerr, through the diagnostics writer when that owns it
+  void warning(Common::StringRef msg);
   void final(unsigned winner, unsigned loser);
+  // Reports the board and the moves of the player to move as
+  // "GUI | <dumpState> | <listMoves>". With guiDeltas only the first report
+  // is whole, the rest are "DELTA | <i>=<token> ... | <listMoves>" for the
+  // tokens of dumpState that changed, counting from 0. Without guiMoves the
+  // moves are left empty
   void printGUIInfo();
 
   GameState gs;
-  std::set<std::string> echo;
+  ModeratorOptions options;
+  Output output;
+  // Reused for every message handed to output
+  std::string outgoing;
+  // Broadcasts the relay has yet to echo back
+  EchoQueue echoes;
+  // Reused for every message received
+  Common::Tokens msgTokens;
+  // The board as of the last GUI report and both boards' tokens
+  std::string guiBoard;
+  Common::Tokens guiTokens;
+  Common::Tokens boardTokens;
   std::vector<std::string> names;
   std::array<std::string, 2> playerNames;
   std::array<unsigned, 2> playerIds;
   std::ofstream log;
   bool logging;
+  // Write the log and diagnostics when logFlushInterval is set
+  std::unique_ptr<Logger> logWriter;
+  std::unique_ptr<Logger> diagnosticsWriter;
+  Common::Timer moveTimer;
+  std::chrono::steady_clock::time_point turnStart;
+  // Seconds left on each player's clock as of the start of the turn
+  std::array<double, 2> clocks;
+  unsigned turn;
   int turnCount;
+  int winnerIdx;
+  bool over;
 };
 } // namespace Common
 
@@ -63,12 +232,45 @@ private:
 //------------------------------------------------------------------------------
 
 namespace Common {
+template <typename GameState>
+bool readOpeningSuite(const std::string &path, std::vector<std::string> &states,
+                      size_t &badLine) {
+  badLine = 0;
+  std::ifstream in(path.c_str());
+  if (!in)
+    return false;
+
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(in, line)) {
+    ++lineNumber;
+    Common::trim(line);
+    if (line.empty() || line[0] == '#')
+      continue;
+    if (line.compare(0, 10, "LOADSTATE ") == 0)
+      line.erase(0, 10);
+
+    // Stored as dumped so every state reads the same way in the logs
+    GameState gs;
+    if (!gs.loadState(line) || gs.gameOver()) {
+      badLine = lineNumber;
+      return false;
+    }
+    states.push_back(gs.dumpState());
+  }
+  return !states.empty();
+}
+
 template <typename GameState, typename GameClient>
 Moderator<GameState, GameClient>::Moderator()
-    : logging(false) {}
+    : logging(false), clocks{{0.0, 0.0}}, turn(0), turnCount(0), winnerIdx(-1),
+      over(false) {}
 
 template <typename GameState, typename GameClient>
 Moderator<GameState, GameClient>::~Moderator() {
+  // Whatever is still queued is written first
+  logWriter.reset();
+  diagnosticsWriter.reset();
   if (log.is_open())
     log.close();
 }
@@ -79,200 +281,524 @@ void Moderator<GameState, GameClient>::playGame(bool printBoard, bool quiet,
                                                 bool logGame,
                                                 bool enforceTimeLimit,
                                                 bool forbidDuplicateStates) {
+  ModeratorOptions relayOptions;
+  relayOptions.printBoard = printBoard;
+  relayOptions.quiet = quiet;
+  relayOptions.turnTimeLimit = turnTimeLimit;
+  relayOptions.logGame = logGame;
+  relayOptions.enforceTimeLimit = enforceTimeLimit;
+  relayOptions.forbidDuplicateStates = forbidDuplicateStates;
+  playGame(relayOptions);
+}
+
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::playGame(const ModeratorOptions &relayOptions) {
   // Identify myself
-  std::cout << "#name moderator\n"
-            << "#master" << std::endl;
+  Common::sendMsg("#name moderator");
+  Common::sendMsg("#master");
+  Common::flushMsgs();
 
   waitForStart();
 
-  // Set up logging
-  if (logGame)
-    setupLogging();
-
-  // Setup the timer
-  Common::Timer moveTimer;
-
-  // Start game
-  if (printBoard){
-    diagnostic("MOVE | Turn: 0 | Player 0: - | Move: - | Elapsed:  -");
-    printGUIInfo();
-  }
-  broadcast(GameClient::startGameMessage(playerNames[0], playerNames[1]));
-
-  // start timer
-  moveTimer.start();
-
-  // Player 1 has turn 0
-  unsigned turn = 0;
-  turnCount = 0;
+  // Everything broadcast comes back through the relay in order. #quit is a
+  // command the GameMaster acts on rather than relays, but it then sends
+  // #quit to every client, the moderator included. A turn's broadcasts go
+  // out together when it passes to the next player
+  echoes.clear();
+  begin(relayOptions, playerNames[0], playerNames[1],
+        [this](const std::string &msg) {
+          echoes.push(msg);
+          Common::sendMsg(msg);
+        });
 
   // Main game loop
+  std::string msg;
   for (;;) {
-    // Read message
-    std::string msg = Common::readMsg();
+    Common::flushMsgs();
+
+    // Read message, without waiting past the deadline of the player to move
+    double wait = timeLeft();
+    if (!Common::readMsg(msg, std::isinf(wait) ? -1.0 : wait)) {
+      enforceDeadline();
+      continue;
+    }
 
     // Ensure it is actually a message
     if (msg.length() == 0) {
-      std::cerr << "Received a message of length 0. Aborting.\n";
+      warning("Received a message of length 0. Aborting.");
       broadcast("#quit");
+      Common::flushMsgs();
       break;
     }
 
-    std::vector<std::string> tokens = Common::split(msg);
+    bool echo;
+    {
+      PROFILE_ZONE(Parse);
+      Common::tokenize(msg, msgTokens);
+      // Look for echoes
+      echo = echoes.pop(msg);
+    }
+    if (echo)
+      continue;
 
-    // Stop the timer
-    moveTimer.stop();
+    // The result is in, wait for the relay to shut down
+    if (over)
+      continue;
+
+    // Polls for players sent before the game began may still be answered
+    if (gameMasterNotice(msgTokens))
+      continue;
 
-    // Look for echoes
-    std::set<std::string>::iterator it = echo.find(msg);
-    if (it != echo.end()) {
-      // We received an expected echo
-      echo.erase(it);
+    // Work out which player sent the message
+    unsigned id;
+    if (Common::parseUnsigned(msgTokens[0], id) != Common::ParseError::None) {
+      char buffer[256];
+      Common::FormatBuffer warningMsg(buffer);
+      warningMsg << "Received message not prefixed by player ID. Expected "
+                    "first token of " << msg << " to be the player ID. "
+                    "Instead found '" << msgTokens[0] << "'";
+      warning(warningMsg.str());
       continue;
     }
 
-    // Enforce that the message was sent by the correct player
-    try {
-      unsigned player = static_cast<unsigned>(std::stoi(tokens[0]));
-      if (player != playerIds[turn]) {
-        std::cerr << "Received out of turn message '" << msg << "'from "
-                  << playerNames[static_cast<unsigned>(std::stoi(tokens[0]))]
-                  << ". They automatically forfeit.\n";
-        std::stringstream forfeitMsg;
-        forfeitMsg << "FINAL " << playerNames[turn] << " BEATS " << playerNames[(turn + 1) % 2];
-        broadcast(forfeitMsg.str());
-        broadcast("#quit");
-        break;
+    unsigned player;
+    if (id == playerIds[0]) {
+      player = 0;
+    } else if (id == playerIds[1]) {
+      player = 1;
+    } else {
+      if (!options.quiet) {
+        char buffer[256];
+        Common::FormatBuffer warningMsg(buffer);
+        warningMsg << "Received message '" << msg
+                   << "' from a client that is not playing";
+        warning(warningMsg.str());
       }
-      tokens.erase(tokens.begin(), tokens.begin() + 1);
-    } catch (std::invalid_argument e) {
-      std::cerr << "Received message not prefixed by player ID. Expected first "
-                   "token of " << msg << " to be the player ID. Instead found '"
-                << tokens[0] << "'\n";
       continue;
     }
+    msgTokens.erase(msgTokens.begin());
 
-    if (GameClient::isValidMoveMessage(tokens)) {
-      ++turnCount;
-      // Print out turn and time information
-      std::stringstream timeMsg;
-      timeMsg << "MOVE | Turn: " << turnCount << " | Player " << playerIds[turn] << ": "
-              << playerNames[turn] << " | Move: " << msg <<" | Elapsed: " << moveTimer;
-      diagnostic(timeMsg.str());
-
-
-      // Took too long
-      if (enforceTimeLimit && moveTimer.seconds_elapsed() > turnTimeLimit) {
-        std::stringstream forfeitMsg;
-        forfeitMsg << "Too long. Exceeds time limit of " << turnTimeLimit
-                   << " seconds. "
-                   << "Took " << moveTimer.seconds_elapsed() << " seconds. "
-                   << playerIds[turn] << ":" << playerNames[turn]
-                   << " forfeits.";
-        diagnostic(forfeitMsg.str());
-
-        final((turn + 1) % 2, turn);
-        broadcast("#quit");
-        continue;
-      }
+    handleMove(player, msg, msgTokens);
+  }
+}
 
-      // Received move from current player
-      auto m = gs.translateToLocal(tokens);
+template <typename GameState, typename GameClient>
+bool Moderator<GameState, GameClient>::begin(const ModeratorOptions &gameOptions,
+                                             const std::string &player1,
+                                             const std::string &player2,
+                                             Output gameOutput) {
+  options = gameOptions;
+  output = gameOutput;
+  playerNames = {{player1, player2}};
+  turn = 0;
+  turnCount = 0;
+  winnerIdx = -1;
+  over = false;
+  clocks = {{options.clockBase, options.clockBase}};
+
+  // Players are told apart by name
+  if (player1 == player2) {
+    diagnostic("Both players have duplicate names: " + player1);
+    over = true;
+    return false;
+  }
 
-      // Validate move
-      if (!gs.isValidMove(m)) {
-        std::stringstream invalidMsg;
-        invalidMsg << "Invalid move: " << msg;
-        diagnostic(invalidMsg.str());
+  if (!options.startState.empty()) {
+    if (!gs.loadState(options.startState) || gs.gameOver()) {
+      diagnostic("Cannot start from state: " + options.startState);
+      over = true;
+      return false;
+    }
+    turn = gs.getCurrentPlayer() == 2 ? 1 : 0;
+  }
 
-        final((turn + 1) % 2, turn);
-        broadcast("#quit");
-        continue;
-      }
+  // Set up logging
+  if (options.logGame)
+    setupLogging();
+  if (options.logFlushInterval > 0.0) {
+    if (logging)
+      logWriter.reset(new Logger(log, options.logFlushInterval));
+    if (options.diagnostics != nullptr)
+      diagnosticsWriter.reset(new Logger(*options.diagnostics, options.logFlushInterval));
+  }
 
-      // Apply move and echo it
-      gs.applyMove(m);
+  // Start game
+  guiBoard.clear();
+  if (options.printBoard) {
+    diagnostic("MOVE | Turn: 0 | Player 0: - | Move: - | Elapsed:  -");
+    printGUIInfo();
+  }
+  if (!options.startState.empty())
+    broadcast(GameClient::loadStateMessage(gs.dumpState()));
+  char buffer[128];
+  Common::FormatBuffer startMsg(buffer);
+  broadcast(GameClient::startGameMessage(playerNames[0], playerNames[1], startMsg));
 
-      // Print GUI info after new move
-      if (printBoard)
-        printGUIInfo();
+  // Player 1 has turn 0
+  startTurn();
+  return true;
+}
 
-      // Check for duplicated moves
-      if (forbidDuplicateStates && gs.seenDuplicatedState()) {
-        std::stringstream invalidMsg;
-        invalidMsg << "State duplicated by move: " << msg;
-        diagnostic(invalidMsg.str());
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::handleMessage(unsigned player,
+                                                     const std::string &msg) {
+  if (over)
+    return;
+
+  {
+    PROFILE_ZONE(Parse);
+    Common::tokenize(msg, msgTokens);
+  }
+  handleMove(player, msg, msgTokens);
+}
 
-        final((turn + 1) % 2, turn);
-        broadcast("#quit");
-        continue;
-      }
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::playMove(unsigned player, const Move &move) {
+  if (over)
+    return;
+
+  char buffer[64];
+  Common::FormatBuffer moveMsg(buffer);
+  if (player != turn)
+    outOfTurn(player, GameClient::moveMessage(move, moveMsg));
+  else
+    play(move, GameClient::moveMessage(move, moveMsg));
+}
 
-      broadcast(GameClient::moveMessage(m));
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::handleMove(
+    unsigned player, const std::string &msg, const Common::Tokens &tokens) {
+  // Enforce that the message was sent by the correct player
+  if (player != turn) {
+    outOfTurn(player, msg);
+    return;
+  }
 
-      // Start timer for next player's move
-      moveTimer.start();
+  if (GameClient::isValidMoveMessage(tokens)) {
+    // Received move from current player
+    Move m{};
+    {
+      PROFILE_ZONE(Parse);
+      m = gs.translateToLocal(tokens);
+    }
+    play(m, msg);
+  } else {
+    if (!options.quiet) {
+      char buffer[256];
+      Common::FormatBuffer warningMsg(buffer);
+      warningMsg << "Received unknown message: " << msg;
+      warning(warningMsg.str());
+    }
+  }
+}
 
-      // Check if game is over
-      if (gs.gameOver()) {
-        unsigned winner = gs.winner() == 1 ? 0 : 1;
-        unsigned loser = winner == 0 ? 1 : 0;
-        final(winner, loser);
-        broadcast("#quit");
-        continue;
-      }
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::outOfTurn(unsigned player,
+                                                 Common::StringRef msg) {
+  char buffer[256];
+  Common::FormatBuffer warningMsg(buffer);
+  warningMsg << "Received out of turn message '" << msg << "'from "
+             << playerNames[player] << ". They automatically forfeit.";
+  warning(warningMsg.str());
+  final(turn, player);
+  broadcast("#quit");
+}
 
-      // Alternate whose turn
-      turn = (turn + 1) % 2;
-    } else {
-      if (!quiet)
-        std::cerr << "Received unknown message: " << msg << std::endl;
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::play(const Move &m, Common::StringRef msg) {
+  // Stop the timer
+  moveTimer.stop();
+  double elapsed = turnElapsed();
+
+  ++turnCount;
+  // Print out turn and time information
+  char buffer[256];
+  Common::FormatBuffer timeMsg(buffer);
+  timeMsg << "MOVE | Turn: " << turnCount << " | Player " << turn + 1 << ": "
+          << playerNames[turn] << " | Move: " << msg << " | Elapsed: " << moveTimer;
+  diagnostic(timeMsg.str());
+
+  // Took too long
+  if (options.enforceTimeLimit &&
+      moveTimer.seconds_elapsed() > options.turnTimeLimit) {
+    Common::FormatBuffer forfeitMsg(buffer);
+    forfeitMsg << "Too long. Exceeds time limit of " << options.turnTimeLimit
+               << " seconds. "
+               << "Took " << moveTimer.seconds_elapsed() << " seconds. "
+               << turn + 1 << ":" << playerNames[turn] << " forfeits.";
+    diagnostic(forfeitMsg.str());
+
+    final((turn + 1) % 2, turn);
+    broadcast("#quit");
+    return;
+  }
+
+  // Ran out on the clock, otherwise the increment is earned
+  if (usesClock()) {
+    clocks[turn] -= elapsed;
+    if (clocks[turn] < 0.0) {
+      Common::FormatBuffer forfeitMsg(buffer);
+      forfeitMsg << "Too long. Ran out of time on the clock, "
+                 << -clocks[turn] << " seconds over. " << turn + 1 << ":"
+                 << playerNames[turn] << " forfeits.";
+      diagnostic(forfeitMsg.str());
+
+      final((turn + 1) % 2, turn);
+      broadcast("#quit");
+      return;
     }
+    clocks[turn] += options.clockIncrement;
+  }
+
+  // Validate move
+  bool valid;
+  {
+    PROFILE_ZONE(Validate);
+    valid = gs.isValidMove(m);
+  }
+  if (!valid) {
+    Common::FormatBuffer invalidMsg(buffer);
+    invalidMsg << "Invalid move: " << msg;
+    diagnostic(invalidMsg.str());
+
+    final((turn + 1) % 2, turn);
+    broadcast("#quit");
+    return;
+  }
+
+  // Apply move and echo it
+  {
+    PROFILE_ZONE(Apply);
+    gs.applyMove(m);
+  }
+
+  // Print GUI info after new move
+  if (options.printBoard)
+    printGUIInfo();
+
+  // Check for duplicated moves
+  bool duplicated = false;
+  if (options.forbidDuplicateStates) {
+    PROFILE_ZONE(Apply);
+    duplicated = gs.seenDuplicatedState();
+  }
+  if (duplicated) {
+    Common::FormatBuffer invalidMsg(buffer);
+    invalidMsg << "State duplicated by move: " << msg;
+    diagnostic(invalidMsg.str());
+
+    final((turn + 1) % 2, turn);
+    broadcast("#quit");
+    return;
+  }
+
+  Common::FormatBuffer moveMsg(buffer);
+  broadcast(GameClient::moveMessage(m, moveMsg));
+
+  // Check if game is over
+  if (gs.gameOver()) {
+    unsigned winner = gs.winner() == 1 ? 0 : 1;
+    unsigned loser = winner == 0 ? 1 : 0;
+    final(winner, loser);
+    broadcast("#quit");
+    return;
+  }
+
+  if (adjudicate())
+    return;
+
+  // Alternate whose turn
+  turn = (turn + 1) % 2;
+
+  // Start timer for next player's move
+  startTurn();
+}
+
+template <typename GameState, typename GameClient>
+bool Moderator<GameState, GameClient>::adjudicate() {
+  int winner;
+  char reasonBuffer[128];
+  Common::FormatBuffer reason(reasonBuffer);
+  if (options.adjudicateRaces && (winner = gs.raceWinner()) > 0) {
+    int loser = winner == 1 ? 2 : 1;
+    reason << "Race. Player " << winner << " needs at most "
+           << gs.raceCount(winner) << " moves to finish, player " << loser
+           << " has " << gs.raceCount(loser) << " steps to go";
+  } else if (options.maxPlies > 0 && turnCount >= options.maxPlies) {
+    winner = gs.raceLeader();
+    reason << "Ply limit of " << options.maxPlies << ". Race counts are "
+           << gs.raceCount(1) << " and " << gs.raceCount(2);
+  } else {
+    return false;
   }
+
+  unsigned first = static_cast<unsigned>(winner - 1);
+  char buffer[256];
+  Common::FormatBuffer adjudicatedMsg(buffer);
+  adjudicatedMsg << "Adjudicated: " << reason.str() << ". " << winner << ":"
+                 << playerNames[first] << " wins.";
+  diagnostic(adjudicatedMsg.str());
+
+  final(first, 1 - first);
+  broadcast("#quit");
+  return true;
+}
+
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::forfeit(unsigned player,
+                                               const std::string &reason) {
+  if (over)
+    return;
+
+  char buffer[256];
+  Common::FormatBuffer forfeitMsg(buffer);
+  forfeitMsg << "Forfeit: " << reason << ". " << player + 1 << ":"
+             << playerNames[player] << " forfeits.";
+  diagnostic(forfeitMsg.str());
+
+  final((player + 1) % 2, player);
+  broadcast("#quit");
+}
+
+template <typename GameState, typename GameClient>
+double Moderator<GameState, GameClient>::timeLeft() const {
+  double left = std::numeric_limits<double>::infinity();
+  if (over)
+    return left;
+
+  double elapsed = turnElapsed();
+  if (options.enforceTimeLimit)
+    left = options.turnTimeLimit - elapsed;
+  if (usesClock())
+    left = std::min(left, clocks[turn] - elapsed);
+  return left;
+}
+
+template <typename GameState, typename GameClient>
+bool Moderator<GameState, GameClient>::enforceDeadline() {
+  if (timeLeft() > 0.0)
+    return false;
+
+  char buffer[256];
+  Common::FormatBuffer forfeitMsg(buffer);
+  if (usesClock() && clocks[turn] - turnElapsed() <= 0.0)
+    forfeitMsg << "Too long. Ran out of time on the clock without moving. ";
+  else
+    forfeitMsg << "Too long. Exceeds time limit of " << options.turnTimeLimit
+               << " seconds without moving. ";
+  forfeitMsg << turn + 1 << ":" << playerNames[turn] << " forfeits.";
+  diagnostic(forfeitMsg.str());
+
+  final((turn + 1) % 2, turn);
+  broadcast("#quit");
+  return true;
+}
+
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::comment(Common::StringRef msg) {
+  diagnostic(msg);
+}
+
+template <typename GameState, typename GameClient>
+bool Moderator<GameState, GameClient>::finished() const {
+  return over;
 }
 
+template <typename GameState, typename GameClient>
+int Moderator<GameState, GameClient>::winner() const {
+  return winnerIdx;
+}
+
+template <typename GameState, typename GameClient>
+int Moderator<GameState, GameClient>::moves() const {
+  return turnCount;
+}
+
+template <typename GameState, typename GameClient>
+unsigned Moderator<GameState, GameClient>::playerToMove() const {
+  return turn;
+}
+
+template <typename GameState, typename GameClient>
+const std::string &
+Moderator<GameState, GameClient>::playerName(unsigned player) const {
+  return playerNames[player];
+}
 
 template <typename GameState, typename GameClient>
 void Moderator<GameState, GameClient>::waitForStart() {
+  // Ask to be told "#joined ID NAME" as clients name themselves. A GameMaster
+  // that does this starts with the clients already named, so with the
+  // moderator. Until one is told it is polled with #players, less often after
+  // every answer, in case it does not
+  Common::sendMsg("#notify");
+  Common::flushMsgs();
+  bool notified = false;
+  unsigned joined = 0;
+  double pollDelay = 0.02;
+  const double maxPollDelay = 0.5;
+
   // Wait for the game to begin
   for (;;) {
-    std::cout << "#players" << std::endl;
-    std::string response = Common::readMsg();
-    std::vector<std::string> tokens = Common::split(response);
-
-    int players;
-    try {
-      players = std::stoi(tokens[1]);
-    } catch (std::invalid_argument e) {
-      std::cerr << "Expected number of players as token[1] of " << response
-                << " to be int, instead found '" << tokens[1] << "'\n";
+    std::string response;
+    if (!Common::readMsg(response, notified ? -1.0 : pollDelay)) {
+      Common::sendMsg("#players");
+      Common::flushMsgs();
+      pollDelay = std::min(2 * pollDelay, maxPollDelay);
       continue;
-    } catch (std::out_of_range e) {
-      std::cerr << "Expected number of players as token[1] of " << response
-                << " to be int, instead found '" << tokens[1] << "'\n";
+    }
+    Common::tokenize(response, msgTokens);
+
+    unsigned client;
+    if (msgTokens.size() == 3 && msgTokens[0] == "#joined" &&
+        Common::parseUnsigned(msgTokens[1], client) == Common::ParseError::None) {
+      notified = true;
+      if (client >= names.size())
+        names.resize(client + 1);
+      if (names[client].empty())
+        ++joined;
+      names[client] = msgTokens[2].str();
+      if (joined >= 3)
+        break;
       continue;
     }
 
+    int players;
+    if (msgTokens.size() < 2 ||
+        Common::parseInt(msgTokens[1], players) != Common::ParseError::None) {
+      char buffer[256];
+      Common::FormatBuffer warningMsg(buffer);
+      warningMsg << "Expected number of players as token[1] of " << response
+                 << " to be int, instead found '"
+                 << (msgTokens.size() < 2 ? Common::StringRef() : msgTokens[1])
+                 << "'";
+      warning(warningMsg.str());
+      continue;
+    }
 
-    if (tokens.size() == 2 && tokens[0] == "#players" && players >= 3) {
+    if (msgTokens.size() == 2 && msgTokens[0] == "#players" && players >= 3) {
       // Enough have joined. Get player names
+      names.clear();
       for (int i = 0; i < players; ++i) {
-        std::cout << "#getname " << i << std::endl;
-        std::string name = Common::readMsg();
-        std::vector<std::string> nameTokens  = Common::split(name);
-        try {
-          if (nameTokens.size() == 3 && nameTokens[0] == "#getname" &&
-              std::stoi(nameTokens[1]) == i) {
-            names.push_back(nameTokens[2]);
-          } else {
-            std::cerr << "Did not received expected response '#getname " << i
-                      << " name'."
-                      << " Received message '" << name << "'" << std::endl;
-          }
-        } catch (std::invalid_argument e) {
-          std::cerr << "Expected integer as tokens[1] of " << name
-                    << " instead found '" << nameTokens[1] << "'\n";
-          continue;
+        Common::sendMsg("#getname " + std::to_string(i));
+        Common::flushMsgs();
+        std::string name;
+        do {
+          name = Common::readMsg();
+          Common::tokenize(name, msgTokens);
+        } while (gameMasterNotice(msgTokens));
+        int id;
+        if (msgTokens.size() == 3 && msgTokens[0] == "#getname" &&
+            Common::parseInt(msgTokens[1], id) == Common::ParseError::None &&
+            id == i) {
+          names.push_back(msgTokens[2].str());
+        } else {
+          char buffer[256];
+          Common::FormatBuffer warningMsg(buffer);
+          warningMsg << "Did not received expected response '#getname " << i
+                     << " name'."
+                     << " Received message '" << name << "'";
+          warning(warningMsg.str());
         }
       }
       break;
@@ -282,10 +808,14 @@ void Moderator<GameState, GameClient>::waitForStart() {
   // Determine player names
   unsigned i = 0;
   for (unsigned j = 0; j < names.size(); ++j) {
-    if (names[j] != "moderator" && names[j] != "observer") {
-      if (i > 1)
-        std::cerr << "Too many clients connected, using only "
-                  << playerNames[0] << " and " << playerNames[1] << std::endl;
+    if (!names[j].empty() && names[j] != "moderator" && names[j] != "observer") {
+      if (i > 1) {
+        char buffer[256];
+        Common::FormatBuffer warningMsg(buffer);
+        warningMsg << "Too many clients connected, using only "
+                   << playerNames[0] << " and " << playerNames[1];
+        warning(warningMsg.str());
+      }
 
       playerNames[i] = names[j];
       playerIds[i] = j;
@@ -295,55 +825,134 @@ void Moderator<GameState, GameClient>::waitForStart() {
 
   // Verify a game can begin
   if (playerNames[0] == playerNames[1]) {
-    std::cerr << "Both players have duplicate names: " << playerNames[0]
-              << std::endl;
-    std::cout << "FINAL " << playerNames[0] << " beats " << playerNames[1]
-              << std::endl;
-    std::cout << "#quit" << std::endl;
+    warning("Both players have duplicate names: " + playerNames[0]);
+    Common::sendMsg("FINAL " + playerNames[0] + " beats " + playerNames[1]);
+    Common::sendMsg("#quit");
+    Common::flushMsgs();
     std::exit(1);
   }
 }
 
 
+template <typename GameState, typename GameClient>
+bool Moderator<GameState, GameClient>::gameMasterNotice(
+    const Common::Tokens &tokens) {
+  return tokens.size() > 0 &&
+         (tokens[0] == "#joined" || tokens[0] == "#players");
+}
+
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::startTurn() {
+  if (usesClock() && options.announceTime) {
+    char buffer[64];
+    Common::FormatBuffer timeMsg(buffer);
+    timeMsg << "TIME " << static_cast<long long>(clocks[0] * 1000) << " "
+            << static_cast<long long>(clocks[1] * 1000);
+    broadcast(timeMsg.str());
+  }
+
+  moveTimer.start();
+  turnStart = std::chrono::steady_clock::now();
+}
+
+template <typename GameState, typename GameClient>
+double Moderator<GameState, GameClient>::turnElapsed() const {
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - turnStart;
+  return elapsed.count();
+}
+
+template <typename GameState, typename GameClient>
+bool Moderator<GameState, GameClient>::usesClock() const {
+  return options.clockBase > 0.0;
+}
+
 template <typename GameState, typename GameClient>
 void Moderator<GameState, GameClient>::setupLogging() {
-  std::string filename = playerNames[0] + "-vs-" + playerNames[1] + ".txt";
+  std::string filename = options.logPath;
+  if (filename.empty())
+    filename = playerNames[0] + "-vs-" + playerNames[1] + ".txt";
   log.open(filename.c_str());
   logging = true;
 }
 
 template <typename GameState, typename GameClient>
-void Moderator<GameState, GameClient>::broadcast(const std::string &msg) {
-  echo.insert(msg);
-  if (logging)
-    log << msg << std::endl;
-  std::cout << msg << std::endl;
+void Moderator<GameState, GameClient>::broadcast(Common::StringRef msg) {
+  PROFILE_ZONE(Broadcast);
+  // The log is flushed as it is closed, not every line
+  if (logWriter)
+    logWriter->write(msg);
+  else if (logging)
+    log << msg << '\n';
+  if (output) {
+    outgoing.assign(msg.data(), msg.size());
+    output(outgoing);
+  }
 }
 
 template <typename GameState, typename GameClient>
-void Moderator<GameState, GameClient>::diagnostic(const std::string &msg) {
-  if (logging)
-    log << "# " << msg << std::endl;
-  std::cerr << msg << std::endl;
+void Moderator<GameState, GameClient>::diagnostic(Common::StringRef msg) {
+  if (logWriter) {
+    logWriter->append("# ");
+    logWriter->write(msg);
+  } else if (logging) {
+    log << "# " << msg << '\n';
+  }
+
+  if (diagnosticsWriter)
+    diagnosticsWriter->write(msg);
+  else if (options.diagnostics != nullptr)
+    *options.diagnostics << msg << '\n';
+}
+
+template <typename GameState, typename GameClient>
+void Moderator<GameState, GameClient>::warning(Common::StringRef msg) {
+  // The writer alone may touch the stream while it runs
+  if (diagnosticsWriter && options.diagnostics == &std::cerr)
+    diagnosticsWriter->write(msg);
+  else
+    std::cerr << msg << '\n';
 }
 
 template <typename GameState, typename GameClient>
 void Moderator<GameState, GameClient>::final(unsigned winner, unsigned loser) {
-  std::stringstream finalMsg;
+  char buffer[128];
+  Common::FormatBuffer finalMsg(buffer);
   finalMsg << "FINAL " << playerNames[winner] << " BEATS "
            << playerNames[loser];
   broadcast(finalMsg.str());
-  std::stringstream movecountMsg;
+  // The GameMaster stops the moderator once the game is over
+  PROFILE_REPORT();
+  Common::FormatBuffer movecountMsg(buffer);
   movecountMsg << turnCount << " moves were played in total";
   diagnostic(movecountMsg.str());
+
+  winnerIdx = static_cast<int>(winner);
+  over = true;
 }
 
 template <typename GameState, typename GameClient>
 void Moderator<GameState, GameClient>::printGUIInfo() {
-  std::stringstream gui;
-
-  gui << "GUI | " <<  gs.dumpState() << " | " << gs.listMoves();
+  char board[GameState::MaxDumpSize];
+  Common::StringRef boardText(board, gs.dumpState(board));
+  char buffer[1024];
+  Common::FormatBuffer gui(buffer);
+
+  Common::tokenize(boardText, boardTokens);
+  Common::tokenize(guiBoard, guiTokens);
+  if (!options.guiDeltas || boardTokens.size() != guiTokens.size()) {
+    gui << "GUI | " << boardText;
+  } else {
+    gui << "DELTA |";
+    for (size_t i = 0; i < boardTokens.size(); ++i)
+      if (boardTokens[i] != guiTokens[i])
+        gui << ' ' << i << '=' << boardTokens[i];
+  }
+  gui << " | ";
+  if (options.guiMoves)
+    gs.listMoves(gui);
 
+  guiBoard.assign(boardText.data(), boardText.size());
   diagnostic(gui.str());
 }
 } //namespace Common
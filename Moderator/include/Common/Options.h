@@ -0,0 +1,70 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Parses the command line options the game programs share
+///
+/// The moderator, ChineseCheckersMatch, ChineseCheckersServer and
+/// ChineseCheckersTournament take the same options for the rules and limits
+/// of a game. Each program walks its own arguments and hands every one it
+/// does not know itself to parseModeratorOption or parseMatchOption, so the
+/// options are spelt, validated and reported the same way everywhere.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_OPTIONS_H_INCLUDED
+#define COMMON_OPTIONS_H_INCLUDED
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Common/Match.h"
+#include "Common/Moderator.h"
+
+namespace Common {
+// Parses a whole number of at least 1. Reports arg on std::cerr and returns
+// fallback if it is not one
+int parseCount(const char *arg, int fallback);
+
+// Parses a number. Reports arg on std::cerr and returns false, leaving value
+// alone, if it is not one
+bool parseDouble(const char *arg, double &value);
+
+// Parses argv[i] if it is one of the options for the rules of a game:
+//   --enforce [SECONDS], --clock BASE+INC, --announce-time, --adjudicate,
+//   --max-plies N, --allow-dupe-states, --async-log MS
+// Returns true with i on the last argument it used, or false with i
+// unchanged if it is not one of them or its argument is missing. A value
+// that does not parse is reported on std::cerr and leaves its option alone
+bool parseModeratorOption(int argc, char **argv, int &i,
+                          ModeratorOptions &options);
+
+// As parseModeratorOption, and also the limits on the agents:
+//   --cpus LIST, --memory MB, --address-space MB
+bool parseMatchOption(int argc, char **argv, int &i, MatchSpec &spec);
+
+// Reads an opening suite with readOpeningSuite, reporting on std::cerr why
+// it could not be read
+template <typename GameState>
+bool readOpenings(const std::string &path, std::vector<std::string> &openings);
+} // namespace Common
+
+// Implementation
+//------------------------------------------------------------------------------
+
+namespace Common {
+template <typename GameState>
+bool readOpenings(const std::string &path, std::vector<std::string> &openings) {
+  size_t badLine;
+  if (readOpeningSuite<GameState>(path, openings, badLine))
+    return true;
+
+  if (badLine > 0)
+    std::cerr << path << ":" << badLine << ": not a state a game can start from"
+              << std::endl;
+  else
+    std::cerr << "Could not read any states from " << path << std::endl;
+  return false;
+}
+} // namespace Common
+
+#endif
@@ -0,0 +1,98 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Defines a child process connected through pipes
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_PROCESS_H_INCLUDED
+#define COMMON_PROCESS_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace Common {
+/// How a process is run
+struct ProcessOptions {
+  // Send its stderr to /dev/null instead of sharing this process's
+  bool discardErrors = false;
+  // CPUs it and its children may run on, any if empty. Only applied on Linux
+  std::vector<int> cpus;
+  // Bytes of address space each of its processes may map, as RLIMIT_AS,
+  // unlimited if 0. Allocations past it fail rather than swapping the host
+  size_t addressSpaceLimit = 0;
+};
+
+/// A program running in its own process group, with its stdin and stdout
+/// connected to non-blocking pipes. The pipes are not inherited by other
+/// children, so each sees end of file as soon as its own peer exits
+class Process {
+public:
+  Process();
+  ~Process();
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  Process(const Process &) = delete;
+  // move ctor
+  Process(const Process &&) = delete;
+  // copy assignment
+  Process &operator=(const Process &) = delete;
+  // move assignment
+  Process &operator=(const Process &&) = delete;
+
+  // Runs args[0], searched for on the PATH, with args. Returns false if the
+  // program could not be run
+  bool start(const std::vector<std::string> &args,
+             const ProcessOptions &options = ProcessOptions());
+
+  // Kills the process group, closes the pipes and reaps the process
+  void stop();
+
+  // Returns true between a successful start and stop
+  bool running() const;
+
+  // Returns the CPU seconds used by the process, every thread of it and
+  // every process it started. While it runs this is sampled from /proc at
+  // the kernel's tick resolution, covering the processes still alive and
+  // those they have reaped. After stop it is the exact total wait4 reported.
+  // Returns -1 if unknown, as it is while running anywhere but Linux
+  double cpuTime() const;
+
+  // Returns the bytes of memory the process and its living descendants
+  // have had resident at their peaks, from VmHWM in /proc. Returns -1 if
+  // unknown, as it is once stopped or anywhere but Linux
+  long long peakMemory() const;
+
+  pid_t id() const;
+
+  // Writes to the process's stdin
+  int input() const;
+
+  // Reads from the process's stdout
+  int output() const;
+
+private:
+  pid_t pid;
+  int in;
+  int out;
+  // Set by stop from what wait4 reports
+  double finalCpuTime;
+};
+
+/// Splits a command line on spaces, as the GameMaster does
+std::vector<std::string> splitCommand(const std::string &command);
+
+/// Parses a list of CPUs such as "0-3,8,10-11" into cpus. Returns false,
+/// leaving cpus alone, if it is not one or names a CPU past the largest a
+/// CPU set can hold
+bool parseCpuList(const std::string &list, std::vector<int> &cpus);
+
+/// Parses a whole number of megabytes into bytes. Returns false, leaving
+/// bytes alone, if it is not one
+bool parseMegabytes(const std::string &megabytes, size_t &bytes);
+} // namespace Common
+
+#endif
@@ -0,0 +1,105 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Times the phases of moderators and agents
+///
+/// PROFILE_ZONE(Parse) times the rest of the enclosing scope as the Parse
+/// zone. Every thread counts its own zones without locks, and the latencies
+/// go into histograms with four buckets to each power of two of
+/// nanoseconds, so percentiles are within a quarter of their value. Zones
+/// may nest, and each counts all of its time. A summary of every zone
+/// entered by any thread is written to std::cerr at exit. Programs that are
+/// killed at the end of a game rather than left to exit use PROFILE_REPORT()
+/// to write it as the game ends instead.
+///
+/// Zones are only timed in builds with COMMON_PROFILE defined, as with the
+/// PROFILE_ZONES CMake option. Otherwise the macros compile to nothing.
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_PROFILE_H_INCLUDED
+#define COMMON_PROFILE_H_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace Common {
+enum class Zone : unsigned {
+  // Moderators: reading messages that have arrived, tokenizing and
+  // decoding them, checking moves, playing them and sending the results.
+  // Agents read through the same code. Time spent waiting is not counted
+  Read,
+  Parse,
+  Validate,
+  Apply,
+  Broadcast,
+  // Agents: generating moves and choosing one
+  MoveGen,
+  Search,
+  Count
+};
+
+const char *zoneName(Zone zone);
+
+// What every thread has recorded in a zone, in nanoseconds. Percentiles are
+// the top of the bucket they fall in
+struct ZoneSummary {
+  uint64_t count;
+  uint64_t total;
+  uint64_t max;
+  uint64_t p50;
+  uint64_t p90;
+  uint64_t p99;
+};
+
+// Adds a time to the calling thread's counts of zone, as ProfileZone does
+void recordZone(Zone zone, uint64_t nanoseconds);
+
+ZoneSummary summarizeZone(Zone zone);
+
+// Writes a line for every zone entered, with times in microseconds
+void writeProfile(std::ostream &out);
+
+// Writes the summary to std::cerr now, and not again at exit
+void reportProfile();
+
+class ProfileZone {
+public:
+  explicit ProfileZone(Zone which) : zone(which), start(Clock::now()) {}
+  ~ProfileZone() {
+    recordZone(zone, static_cast<uint64_t>(
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             Clock::now() - start)
+                             .count()));
+  }
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  ProfileZone(const ProfileZone &) = delete;
+  // move ctor
+  ProfileZone(const ProfileZone &&) = delete;
+  // copy assignment
+  ProfileZone &operator=(const ProfileZone &) = delete;
+  // move assignment
+  ProfileZone &operator=(const ProfileZone &&) = delete;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+  Zone zone;
+  Clock::time_point start;
+};
+} // namespace Common
+
+#ifdef COMMON_PROFILE
+#define COMMON_PROFILE_JOIN2(a, b) a##b
+#define COMMON_PROFILE_JOIN(a, b) COMMON_PROFILE_JOIN2(a, b)
+#define PROFILE_ZONE(zone)                                                     \
+  ::Common::ProfileZone COMMON_PROFILE_JOIN(profileZone, __LINE__)(            \
+      ::Common::Zone::zone)
+#define PROFILE_REPORT() ::Common::reportProfile()
+#else
+#define PROFILE_ZONE(zone) static_cast<void>(0)
+#define PROFILE_REPORT() static_cast<void>(0)
+#endif
+
+#endif
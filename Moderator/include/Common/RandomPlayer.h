@@ -15,6 +15,8 @@
 #include <vector>
 
 #include "Common/Client.h"
+#include "Common/Format.h"
+#include "Common/Profile.h"
 #include "Common/String.h"
 
 namespace Common {
@@ -33,14 +35,25 @@ public:
   // move assignment
   Random &operator=(const Random &&) = delete;
 
+  // Consult the opening book at path before picking a move
+  void useBook(const std::string &path);
+
+  // Ask the moderator for binary frames, see GameClient::frameSize. Without
+  // an answer the game is played in text
+  void useFrames();
+
   void playGame();
 
 private:
   typedef typename GameClient::Move Move;
+  typedef typename GameClient::Book Book;
   void waitForStart();
   void switchCurrentPlayer();
   Move nextMove();
-  void printAndRecvEcho(std::string msg) const;
+  // Sends msg, a frame once frames are in use, and reads its echo
+  void printAndRecvEcho(Common::StringRef msg) const;
+  // Tells the server what could not be done with m
+  static void reportMove(Common::StringRef what, const Move &m);
 
   enum Players { player1, player2 };
 
@@ -49,6 +62,10 @@ private:
   Players currentPlayer;
   Players me;
   GameState gs;
+  Book book;
+  // Whether frames were asked for, and whether the moderator agreed
+  bool askFrames;
+  bool framed;
   std::random_device rd;
   std::mt19937 mt;
 };
@@ -58,17 +75,32 @@ private:
 //------------------------------------------------------------------------------
 namespace Common {
 template <typename GameState, typename GameClient>
-Random<GameState, GameClient>::Random(std::string &name) : myName(name), rd(), mt(rd()) {}
+Random<GameState, GameClient>::Random(std::string &name)
+    : myName(name), askFrames(false), framed(false), rd(), mt(rd()) {}
+
+template <typename GameState, typename GameClient>
+void Random<GameState, GameClient>::useBook(const std::string &path) {
+  book.open(path);
+}
+
+template <typename GameState, typename GameClient>
+void Random<GameState, GameClient>::useFrames() {
+  askFrames = true;
+}
 
 template <typename GameState, typename GameClient>
 void Random<GameState, GameClient>::playGame() {
   // Identify myself
-  std::cout << "#name " << myName << std::endl;
+  if (askFrames)
+    Common::sendMsg(GameClient::protocolMessage);
+  Common::sendMsg("#name " + myName);
+  Common::flushMsgs();
 
   // Wait for start of game
   waitForStart();
 
   // Main game loop
+  Common::Tokens tokens;
   for (;;) {
     if (currentPlayer == me) {
       // My turn
@@ -85,7 +117,7 @@ void Random<GameState, GameClient>::playGame() {
       if (!gs.isValidMove(m)) {
         std::cerr << "I was about to play an invalid move: "
                   << m << std::endl;
-        std::cout << "#quit" << std::endl;
+        Common::sendMsg("#quit");
       }
 
       // Apply it
@@ -93,7 +125,7 @@ void Random<GameState, GameClient>::playGame() {
 
       if (m.isNull()) {
         // Concede to the server so we know what is going on
-        std::cout << "# I, " << myName << ", have no moves to play." << std::endl;
+        Common::sendMsg("# I, " + myName + ", have no moves to play.");
 
         switchCurrentPlayer();
         // End game locally, server should detect and send #quit
@@ -101,7 +133,13 @@ void Random<GameState, GameClient>::playGame() {
       }
 
       // Tell the world
-      printAndRecvEcho(GameClient::moveMessage(m));
+      if (framed) {
+        printAndRecvEcho(GameClient::moveFrame(m));
+      } else {
+        char buffer[64];
+        Common::FormatBuffer moveMsg(buffer);
+        printAndRecvEcho(GameClient::moveMessage(m, moveMsg));
+      }
 
       // It is the opponents turn
       switchCurrentPlayer();
@@ -109,16 +147,21 @@ void Random<GameState, GameClient>::playGame() {
       // Wait for move from other player
       // Get server's next instruction
       std::string serverMsg = Common::readMsg();
-      std::vector<std::string> tokens = Common::split(serverMsg);
+      Common::tokenize(serverMsg, tokens);
 
-      if (GameClient::isValidMoveMessage(tokens)) {
+      Move m{};
+      bool moved = framed && GameClient::readMoveFrame(serverMsg, m);
+      if (!moved && GameClient::isValidMoveMessage(tokens)) {
         // Translate to local coordinates
-        auto m = gs.translateToLocal(tokens);
+        m = gs.translateToLocal(tokens);
+        moved = true;
+      }
 
+      if (moved) {
         // Double check it is valid
         if (!gs.isValidMove(m)) {
           std::cerr << "Received move from opponent I think is invalid: " << m << std::endl;
-          std::cout << "#quit" << std::endl;
+          Common::sendMsg("#quit");
         }
 
         // Apply the move and continue
@@ -126,6 +169,8 @@ void Random<GameState, GameClient>::playGame() {
 
         // It is now my turn
         switchCurrentPlayer();
+      } else if (!tokens.empty() && tokens[0] == "TIME") {
+        // Clocks are announced before every turn, any move will do
       } else if (tokens.size() == 4 && tokens[0] == "FINAL" &&
                  tokens[2] == "BEATS") {
         // Game over
@@ -138,6 +183,8 @@ void Random<GameState, GameClient>::playGame() {
                     << "Found '" << tokens[1] << "' and '" << tokens[3] << "'. "
                     << "Expected '" << myName << "' and '" << oppName << "'.\n"
                     << "Received message '" << serverMsg << "'" << std::endl;
+        // Agents are stopped once the game is over
+        PROFILE_REPORT();
       } else {
         // Unknown command
         std::cerr << "Unknown command of '" << serverMsg << "' from the server";
@@ -149,20 +196,35 @@ void Random<GameState, GameClient>::playGame() {
 
 template <typename GameState, typename GameClient>
 void Random<GameState, GameClient>::waitForStart() {
+  // The last state loaded is where the game starts, if there was one
+  std::string startState;
+  Common::Tokens tokens;
   for (;;) {
     std::string response = Common::readMsg();
-    std::vector<std::string> tokens = Common::split(response);
-
-    if (GameClient::isValidStartGameMessage(tokens)) {
+    Common::tokenize(response, tokens);
+
+    Move framedMove{};
+    if (askFrames && response == GameClient::protocolMessage) {
+      // Everything from here on may come as frames
+      framed = true;
+      Common::readFrames(GameClient::frameSize);
+    } else if (framed && GameClient::readStateFrame(response, gs)) {
+      startState = gs.dumpState();
+    } else if (framed && response == std::string(1, GameClient::DumpStateFrame)) {
+      Common::sendFrame(GameClient::stateFrame(gs));
+    } else if (framed && GameClient::readMoveFrame(response, framedMove)) {
+      if (!gs.applyMove(framedMove))
+        reportMove("Unable to apply move", framedMove);
+    } else if (GameClient::isValidStartGameMessage(tokens)) {
       // Found BEGIN GAME message, determine if we play first
       if (tokens[2] == myName) {
         // We go first!
-        oppName = tokens[3];
+        oppName = tokens[3].str();
         me = player1;
         break;
       } else if (tokens[3] == myName) {
         // They go first
-        oppName = tokens[2];
+        oppName = tokens[2].str();
         me = player2;
         break;
       } else {
@@ -170,36 +232,40 @@ void Random<GameState, GameClient>::waitForStart() {
                   << "', my name, in the BEGIN command.\n"
                   << "# Found '" << tokens[2] << "' and '" << tokens[3] << "'"
                   << " as player names. Received message '" << response << "'";
-        std::cout << "#quit";
+        Common::sendMsg("#quit");
+        Common::flushMsgs();
         std::exit(EXIT_FAILURE);
       }
     } else if (response == "DUMPSTATE") {
-      std::cout << gs.dumpState() << std::endl;
-    } else if (tokens[0] == "LOADSTATE") {
+      Common::sendMsg(gs.dumpState());
+    } else if (!tokens.empty() && tokens[0] == "LOADSTATE") {
       std::string newState = response.substr(10);
-      if (!gs.loadState(newState))
+      if (gs.loadState(newState))
+        startState = newState;
+      else
         std::cerr << "Failed to load '" << newState << "'\n";
     } else if (response == "LISTMOVES") {
-      std::set<typename GameClient::Move> moves;
-      gs.getMoves(moves);
-      for (const auto i : moves)
-        std::cout << i.from << ", " << i.to << "; ";
-      std::cout << std::endl;
+      char buffer[1024];
+      Common::FormatBuffer list(buffer);
+      Common::sendMsg(gs.listMoves(list));
     } else if (GameClient::isValidMoveMessage(tokens)) {
       // Just apply the move
       const Move m = gs.translateToLocal(tokens);
       if (!gs.applyMove(m))
-        std::cout << "Unable to apply move '" << m << "'" << std::endl;
-    } else if (tokens[0] == "UNDO") {
+        reportMove("Unable to apply move", m);
+    } else if (!tokens.empty() && tokens[0] == "UNDO") {
       tokens[0] = "MOVE";
       if (GameClient::isValidMoveMessage(tokens)) {
         const Move m = gs.translateToLocal(tokens);
         if (!gs.undoMove(m))
-          std::cout << "Unable to undo move '" << m << "'" << std::endl;
+          reportMove("Unable to undo move", m);
       }
     } else if (response == "NEXTMOVE") {
       const Move m = nextMove();
-      std::cout << m.from << ", " << m.to << std::endl;
+      char buffer[64];
+      Common::FormatBuffer next(buffer);
+      next << m.from << ", " << m.to;
+      Common::sendMsg(next.str());
     } else {
       std::cerr << "Unexpected message " << response << "\n";
     }
@@ -208,9 +274,11 @@ void Random<GameState, GameClient>::waitForStart() {
   // Game is about to begin, restore to start state in case DUMPSTATE/LOADSTATE/LISTMOVES
   // were used
   gs.reset();
+  if (!startState.empty())
+    gs.loadState(startState);
 
-  // Player 1 goes first
-  currentPlayer = player1;
+  // Player 1 goes first unless the start state says otherwise
+  currentPlayer = gs.getCurrentPlayer() == 2 ? player2 : player1;
 }
 
 template <typename GameState, typename GameClient>
@@ -220,8 +288,18 @@ void Random<GameState, GameClient>::switchCurrentPlayer() {
 
 template <typename GameState, typename GameClient>
 typename GameClient::Move Random<GameState, GameClient>::nextMove() {
+  PROFILE_ZONE(Search);
+
+  // Book moves cost no time at all
+  Move bookMove;
+  if (book.probe(gs, bookMove))
+    return bookMove;
+
   std::set<typename GameClient::Move> moves;
-  gs.getMoves(moves);
+  {
+    PROFILE_ZONE(MoveGen);
+    gs.getMoves(moves);
+  }
 
   std::uniform_int_distribution<> dis(0, int(moves.size() - 1));
 
@@ -231,15 +309,33 @@ typename GameClient::Move Random<GameState, GameClient>::nextMove() {
 }
 
 template <typename GameState, typename GameClient>
-void Random<GameState, GameClient>::printAndRecvEcho(std::string msg) const {
-   // Note the endl flushes the stream, which is necessary
-  std::cout << msg << std::endl;
-  const std::string echo = Common::readMsg();
+void Random<GameState, GameClient>::printAndRecvEcho(Common::StringRef msg) const {
+  // The move hands the turn over, so it has to go out now
+  if (framed)
+    Common::sendFrame(msg);
+  else
+    Common::sendMsg(msg);
+  Common::flushMsgs();
+  std::string echo = Common::readMsg();
+  // The clocks announced at the start of this turn may not have been read
+  while (echo.compare(0, 5, "TIME ") == 0)
+    echo = Common::readMsg();
+  // The last move may be answered with the result
+  if (echo.compare(0, 6, "FINAL ") == 0)
+    PROFILE_REPORT();
   if (msg != echo)
     std::cerr << "Expected echo of '" << msg << "'. Received '" << echo << "'"
               << std::endl;
 }
 
+template <typename GameState, typename GameClient>
+void Random<GameState, GameClient>::reportMove(Common::StringRef what, const Move &m) {
+  char buffer[128];
+  Common::FormatBuffer error(buffer);
+  error << what << " '{" << m.from << ", " << m.to << "}'";
+  Common::sendMsg(error.str());
+}
+
 } // namespace Common
 
 #endif
@@ -0,0 +1,275 @@
+//===------------------------------------------------------------*- C++ -*-===//
+///
+/// \file
+/// \brief Hosts many games at once in a single process
+///
+/// Every running game is a Match. The agents' pipes are multiplexed with
+/// epoll in one event loop, so hosting a game costs two agent processes and
+/// no threads. Games are queued and started as running ones finish. The loop
+/// wakes up for the earliest deadline of the running games, so an agent that
+/// hangs loses on time rather than holding on to its slot.
+///
+/// Note: Linux only
+///
+//===----------------------------------------------------------------------===//
+#ifndef COMMON_SERVER_H_INCLUDED
+#define COMMON_SERVER_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "Common/Match.h"
+
+namespace Common {
+template <typename GameState, typename GameClient>
+class Server {
+public:
+  // Called with the number of a game, counting from 0, as it finishes
+  typedef std::function<void(size_t game, const MatchResult &result)> Callback;
+
+  // Runs at most concurrency games at a time. With pinGames the agents of
+  // each running game share a CPU of their own, taken from the CPUs their
+  // spec allows or from every CPU if it allows any
+  explicit Server(size_t concurrency, bool pinGames = false);
+  ~Server() = default;
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  Server(const Server &) = delete;
+  // move ctor
+  Server(const Server &&) = delete;
+  // copy assignment
+  Server &operator=(const Server &) = delete;
+  // move assignment
+  Server &operator=(const Server &&) = delete;
+
+  // Queues a game, returning its number
+  size_t add(const MatchSpec &spec);
+
+  // Plays every queued game, calling done as each one finishes. Ignores
+  // SIGPIPE so a dead agent cannot take the server with it. Returns false if
+  // the event loop failed
+  bool run(Callback done);
+
+  // Starts no more queued games and abandons the running ones, which are not
+  // reported. Meant to be called from the callback once the games played so
+  // far have decided whatever they were for
+  void stop();
+
+private:
+  typedef Match<GameState, GameClient> GameMatch;
+
+  // Starts the next queued game that can be started in slot, returning false
+  // if there are none left
+  bool startNext(size_t slot, const Callback &done);
+
+  // Reports and removes the game in slot
+  void finish(size_t slot, const Callback &done);
+
+  // Removes the game in slot without reporting it
+  void abandon(size_t slot);
+
+  // Stops the agents of the game in slot and its events. Its result can be
+  // read afterwards, with the CPU time and peak memory of the whole game
+  void release(size_t slot);
+
+  // Identifies the pipe an event is for
+  static uint64_t eventKey(size_t slot, unsigned player, bool write);
+
+  int epfd;
+  size_t concurrency;
+  bool pin;
+  std::vector<MatchSpec> queue;
+  size_t next;
+  bool stopping;
+  std::vector<std::unique_ptr<GameMatch>> matches;
+  std::vector<size_t> games;
+};
+} // namespace Common
+
+// Implementation
+//------------------------------------------------------------------------------
+
+namespace Common {
+template <typename GameState, typename GameClient>
+Server<GameState, GameClient>::Server(size_t maxGames, bool pinGames)
+    : epfd(-1), concurrency(maxGames == 0 ? 1 : maxGames), pin(pinGames),
+      next(0), stopping(false) {}
+
+template <typename GameState, typename GameClient>
+size_t Server<GameState, GameClient>::add(const MatchSpec &spec) {
+  queue.push_back(spec);
+  return queue.size() - 1;
+}
+
+template <typename GameState, typename GameClient>
+bool Server<GameState, GameClient>::run(Callback done) {
+  std::signal(SIGPIPE, SIG_IGN);
+
+  epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (epfd < 0)
+    return false;
+
+  stopping = false;
+  matches.clear();
+  matches.resize(concurrency);
+  games.assign(concurrency, 0);
+
+  size_t running = 0;
+  for (size_t slot = 0; slot < concurrency; ++slot) {
+    if (startNext(slot, done))
+      ++running;
+  }
+
+  std::array<epoll_event, 64> events;
+  bool ok = true;
+  while (running > 0 && !stopping) {
+    double wait = std::numeric_limits<double>::infinity();
+    for (const auto &match : matches) {
+      if (match != nullptr)
+        wait = std::min(wait, match->timeLeft());
+    }
+
+    int ready = epoll_wait(epfd, events.data(), static_cast<int>(events.size()),
+                           Common::pollTimeout(wait));
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      ok = false;
+      break;
+    }
+
+    for (int i = 0; i < ready; ++i) {
+      uint64_t key = events[static_cast<size_t>(i)].data.u64;
+      size_t slot = static_cast<size_t>(key / 4);
+      unsigned player = static_cast<unsigned>((key / 2) % 2);
+
+      // Slots are only refilled below, so a stale event finds its game over
+      GameMatch *match = matches[slot].get();
+      if (match == nullptr || match->finished())
+        continue;
+
+      if (key % 2 == 1)
+        match->writable(player);
+      else
+        match->readable(player);
+    }
+
+    for (size_t slot = 0; slot < concurrency; ++slot) {
+      if (matches[slot] == nullptr)
+        continue;
+      matches[slot]->enforceDeadline();
+      if (!matches[slot]->finished())
+        continue;
+
+      finish(slot, done);
+      if (!startNext(slot, done))
+        --running;
+    }
+  }
+
+  // Only reached early if epoll failed or the server was stopped
+  for (size_t slot = 0; slot < concurrency; ++slot) {
+    if (matches[slot] == nullptr)
+      continue;
+    if (stopping)
+      abandon(slot);
+    else
+      finish(slot, done);
+  }
+
+  close(epfd);
+  epfd = -1;
+  return ok;
+}
+
+template <typename GameState, typename GameClient>
+void Server<GameState, GameClient>::stop() {
+  stopping = true;
+}
+
+template <typename GameState, typename GameClient>
+bool Server<GameState, GameClient>::startNext(size_t slot, const Callback &done) {
+  while (!stopping && next < queue.size()) {
+    size_t game = next++;
+
+    MatchSpec spec = queue[game];
+    if (pin && spec.agents.cpus.empty()) {
+      long cpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+      spec.agents.cpus.push_back(static_cast<int>(slot % static_cast<size_t>(cpus)));
+    } else if (pin) {
+      int cpu = spec.agents.cpus[slot % spec.agents.cpus.size()];
+      spec.agents.cpus.assign(1, cpu);
+    }
+
+    std::unique_ptr<GameMatch> match(new GameMatch);
+    if (!match->start(spec)) {
+      match->stop();
+      done(game, match->result());
+      continue;
+    }
+
+    // Reads are level triggered. Writes are edge triggered, so they are only
+    // reported when a full pipe drains
+    for (unsigned player = 0; player < 2; ++player) {
+      epoll_event in{};
+      in.events = EPOLLIN;
+      in.data.u64 = eventKey(slot, player, false);
+      epoll_ctl(epfd, EPOLL_CTL_ADD, match->output(player), &in);
+
+      epoll_event out{};
+      out.events = EPOLLOUT | EPOLLET;
+      out.data.u64 = eventKey(slot, player, true);
+      epoll_ctl(epfd, EPOLL_CTL_ADD, match->input(player), &out);
+    }
+
+    matches[slot] = std::move(match);
+    games[slot] = game;
+    return true;
+  }
+  return false;
+}
+
+template <typename GameState, typename GameClient>
+void Server<GameState, GameClient>::finish(size_t slot, const Callback &done) {
+  // The agents are only reaped, and their last peak sampled, once stopped
+  release(slot);
+  MatchResult result = matches[slot]->result();
+  matches[slot].reset();
+  done(games[slot], result);
+}
+
+template <typename GameState, typename GameClient>
+void Server<GameState, GameClient>::abandon(size_t slot) {
+  release(slot);
+  matches[slot].reset();
+}
+
+template <typename GameState, typename GameClient>
+void Server<GameState, GameClient>::release(size_t slot) {
+  GameMatch &match = *matches[slot];
+  for (unsigned player = 0; player < 2; ++player) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, match.output(player), nullptr);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, match.input(player), nullptr);
+  }
+  match.stop();
+}
+
+template <typename GameState, typename GameClient>
+uint64_t Server<GameState, GameClient>::eventKey(size_t slot, unsigned player,
+                                                 bool write) {
+  return static_cast<uint64_t>(slot) * 4 + player * 2 + (write ? 1 : 0);
+}
+} // namespace Common
+
+#endif
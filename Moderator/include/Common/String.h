@@ -8,6 +8,9 @@
 #define STRING_H
 
 #include <algorithm>
+#include <climits>
+#include <cstring>
+#include <ostream>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -42,5 +45,119 @@ inline std::vector<std::string> split(const std::string &s, char delim = ' ') {
   }
   return tokens;
 }
+
+/// Characters owned by someone else, such as a token of a message. Only valid
+/// as long as the characters are
+class StringRef {
+public:
+  StringRef() : ptr(""), len(0) {}
+  StringRef(const char *data, size_t length) : ptr(data), len(length) {}
+  StringRef(const char *s) : ptr(s), len(std::strlen(s)) {}
+  StringRef(const std::string &s) : ptr(s.data()), len(s.size()) {}
+
+  const char *data() const { return ptr; }
+  size_t size() const { return len; }
+  bool empty() const { return len == 0; }
+  const char *begin() const { return ptr; }
+  const char *end() const { return ptr + len; }
+  char operator[](size_t i) const { return ptr[i]; }
+
+  std::string str() const { return std::string(ptr, len); }
+
+  // The characters from pos on, or none if pos is past the end
+  StringRef drop(size_t pos) const {
+    return pos < len ? StringRef(ptr + pos, len - pos) : StringRef();
+  }
+
+  bool startsWith(StringRef prefix) const {
+    return prefix.len <= len && std::memcmp(ptr, prefix.ptr, prefix.len) == 0;
+  }
+
+private:
+  const char *ptr;
+  size_t len;
+};
+
+inline bool operator==(StringRef lhs, StringRef rhs) {
+  return lhs.size() == rhs.size() &&
+         std::memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+
+inline bool operator!=(StringRef lhs, StringRef rhs) { return !(lhs == rhs); }
+
+inline std::ostream &operator<<(std::ostream &out, StringRef s) {
+  return out.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// Tokens of a message, pointing into it. Reusing one for every message keeps
+// its storage, so tokenizing does not allocate once it has grown
+typedef std::vector<StringRef> Tokens;
+
+// Splits s on delim into tokens the way split does, so a trailing delimiter
+// adds no empty token but any other pair of delimiters does
+inline void tokenize(StringRef s, Tokens &tokens, char delim = ' ') {
+  tokens.clear();
+  const char *start = s.begin();
+  while (start != s.end()) {
+    const char *stop = static_cast<const char *>(
+        std::memchr(start, delim, static_cast<size_t>(s.end() - start)));
+    if (stop == nullptr) {
+      tokens.emplace_back(start, static_cast<size_t>(s.end() - start));
+      break;
+    }
+    tokens.emplace_back(start, static_cast<size_t>(stop - start));
+    start = stop + 1;
+  }
+}
+
+// Why a number could not be parsed
+enum class ParseError { None, Invalid, OutOfRange };
+
+// Parses the whole of s as a decimal integer with an optional leading minus
+// sign. Unlike std::stoi nothing else is allowed, not even white space, and
+// nothing is thrown. value is only set on success
+inline ParseError parseInt(StringRef s, int &value) {
+  bool negative = !s.empty() && s[0] == '-';
+  StringRef digits = negative ? s.drop(1) : s;
+  if (digits.empty())
+    return ParseError::Invalid;
+
+  // Accumulated as a negative number, which reaches INT_MIN
+  long long result = 0;
+  bool overflow = false;
+  for (char c : digits) {
+    if (c < '0' || c > '9')
+      return ParseError::Invalid;
+    if (!overflow)
+      result = result * 10 - (c - '0');
+    overflow = overflow || result < INT_MIN;
+  }
+  if (overflow || (!negative && -result > INT_MAX))
+    return ParseError::OutOfRange;
+
+  value = static_cast<int>(negative ? result : -result);
+  return ParseError::None;
+}
+
+// As parseInt, but without a sign
+inline ParseError parseUnsigned(StringRef s, unsigned &value) {
+  if (s.empty())
+    return ParseError::Invalid;
+
+  unsigned long long result = 0;
+  bool overflow = false;
+  for (char c : s) {
+    if (c < '0' || c > '9')
+      return ParseError::Invalid;
+    if (!overflow)
+      result = result * 10 + static_cast<unsigned>(c - '0');
+    overflow = overflow || result > UINT_MAX;
+  }
+  if (overflow)
+    return ParseError::OutOfRange;
+
+  value = static_cast<unsigned>(result);
+  return ParseError::None;
+}
 } // namespace Common
 #endif
@@ -9,11 +9,15 @@
 
 #include <ostream>
 #include <chrono>
+#include <string>
+
+#include "Common/Format.h"
 
 namespace Common {
 class Timer {
 public:
   friend std::ostream &operator<<(std::ostream &os, Timer &t);
+  friend FormatBuffer &operator<<(FormatBuffer &out, Timer &t);
 
   Timer();
 
@@ -31,5 +35,14 @@ private:
   Clock::time_point stop_time;
   Clock::duration elapsed;
 };
+
+// Converts a wait in seconds to a poll or epoll timeout in milliseconds,
+// rounding up so the wait is never cut short. An infinite wait is -1
+int pollTimeout(double seconds);
+
+// Parses a time control of BASE or BASE+INCREMENT seconds, such as "60+0.5".
+// Returns false, leaving base and increment alone, if it is not one
+bool parseTimeControl(const std::string &control, double &base,
+                      double &increment);
 } // namespace Common
 #endif
@@ -1,29 +1,113 @@
 #include "ChineseCheckers/Client.h"
 
-#include <sstream>
+#include <cstdint>
 #include <string>
 
 namespace ChineseCheckers {
 std::string Client::startGameMessage(const std::string &player1, const std::string &player2) {
-  std::stringstream cmd;
-  cmd << "BEGIN CHINESECHECKERS " << player1 << " " << player2;
-  return cmd.str();
+  char buffer[128];
+  Common::FormatBuffer cmd(buffer);
+  return startGameMessage(player1, player2, cmd).str();
 }
 
-bool Client::isValidStartGameMessage(const std::vector<std::string> &tokens) {
+bool Client::isValidStartGameMessage(const Common::Tokens &tokens) {
   return tokens.size() == 4 && tokens[0] == "BEGIN" && tokens[1] == "CHINESECHECKERS";
 }
 
-bool Client::isValidMoveMessage(const std::vector<std::string> &tokens) {
+bool Client::isValidMoveMessage(const Common::Tokens &tokens) {
   return tokens.size() == 5 && tokens[0] == "MOVE" && tokens[1] == "FROM" &&
     //static_cast<unsigned>(std::stoi(tokens[2])) < 81 &&
     tokens[3] == "TO";// && static_cast<unsigned>(std::stoi(tokens[4])) < 81;
 }
 
 std::string Client::moveMessage(Move m) {
-  std::stringstream cmd;
-  cmd << "MOVE FROM " << m.from << " TO " << m.to;
-  return cmd.str();
+  char buffer[64];
+  Common::FormatBuffer cmd(buffer);
+  return moveMessage(m, cmd).str();
+}
+
+std::string Client::loadStateMessage(const std::string &state) {
+  return "LOADSTATE " + state;
+}
+
+Common::StringRef Client::startGameMessage(Common::StringRef player1,
+                                           Common::StringRef player2,
+                                           Common::FormatBuffer &out) {
+  size_t before = out.size();
+  out << "BEGIN CHINESECHECKERS " << player1 << ' ' << player2;
+  return out.str().drop(before);
+}
+
+Common::StringRef Client::moveMessage(Move m, Common::FormatBuffer &out) {
+  size_t before = out.size();
+  out << "MOVE FROM " << m.from << " TO " << m.to;
+  return out.str().drop(before);
+}
+
+const char *const Client::protocolMessage = "#protocol binary";
+
+size_t Client::frameSize(char type) {
+  switch (type) {
+  case MoveFrame:
+    return 3;
+  case StateFrame:
+    return 1 + State::PackedBytes;
+  case DumpStateFrame:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+std::string Client::moveFrame(Move m) {
+  std::string frame(3, MoveFrame);
+  frame[1] = static_cast<char>(m.from);
+  frame[2] = static_cast<char>(m.to);
+  return frame;
+}
+
+bool Client::readMoveFrame(Common::StringRef frame, Move &m) {
+  if (frame.size() != 3 || frame[0] != MoveFrame)
+    return false;
+  m.from = static_cast<unsigned char>(frame[1]);
+  m.to = static_cast<unsigned char>(frame[2]);
+  return true;
+}
+
+std::string Client::stateFrame(const State &state) {
+  uint8_t packed[State::PackedBytes];
+  state.writePacked(packed);
+  std::string frame(1, StateFrame);
+  frame.append(reinterpret_cast<const char *>(packed), sizeof(packed));
+  return frame;
+}
+
+bool Client::readStateFrame(Common::StringRef frame, State &state) {
+  if (frame.size() != 1 + State::PackedBytes || frame[0] != StateFrame)
+    return false;
+  return state.loadPacked(reinterpret_cast<const uint8_t *>(frame.data() + 1));
+}
+
+bool Client::messageFrame(const std::string &msg, std::string &frame) {
+  Common::Tokens tokens;
+  Common::tokenize(msg, tokens);
+
+  Move m;
+  if (isValidMoveMessage(tokens) &&
+      Common::parseUnsigned(tokens[2], m.from) == Common::ParseError::None &&
+      Common::parseUnsigned(tokens[4], m.to) == Common::ParseError::None &&
+      m.from < 81 && m.to < 81) {
+    frame = moveFrame(m);
+    return true;
+  }
+
+  State state;
+  if (!tokens.empty() && tokens[0] == "LOADSTATE" &&
+      state.loadState(Common::StringRef(msg).drop(10))) {
+    frame = stateFrame(state);
+    return true;
+  }
+  return false;
 }
 
 } // namespace ChineseCheckers
@@ -0,0 +1,118 @@
+//===------------------------------------------------------------*- C++ -*-===//
+#include "ChineseCheckers/GameLog.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ChineseCheckers {
+namespace {
+// Returns true iff [begin, end) starts with prefix, advancing begin past it
+bool consume(const char *&begin, const char *end, const char *prefix) {
+  size_t length = std::strlen(prefix);
+  if (static_cast<size_t>(end - begin) < length ||
+      std::memcmp(begin, prefix, length) != 0)
+    return false;
+
+  begin += length;
+  return true;
+}
+
+// Reads a non-negative integer, advancing begin past its digits
+bool consumeUnsigned(const char *&begin, const char *end, unsigned &value) {
+  const char *start = begin;
+  value = 0;
+  while (begin != end && *begin >= '0' && *begin <= '9' && value < 1000000)
+    value = value * 10 + static_cast<unsigned>(*begin++ - '0');
+
+  return begin != start;
+}
+
+// Reads up to the next space or the end of the line
+std::string consumeWord(const char *&begin, const char *end) {
+  const char *start = begin;
+  while (begin != end && *begin != ' ')
+    ++begin;
+
+  return std::string(start, begin);
+}
+
+Move parseMove(const char *begin, const char *end) {
+  unsigned from, to;
+  if (consumeUnsigned(begin, end, from) && consume(begin, end, " TO ") &&
+      consumeUnsigned(begin, end, to) && begin == end)
+    return Move{from, to};
+
+  return Move{0, 0};
+}
+} // namespace
+
+void parseGameLog(const char *begin, const char *end,
+                  std::vector<LoggedGame> &games) {
+  LoggedGame *game = nullptr;
+  size_t lineNumber = 0;
+  std::string startState;
+
+  while (begin != end) {
+    const char *newline =
+        static_cast<const char *>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+    const char *lineEnd = newline != nullptr ? newline : end;
+    const char *next = newline != nullptr ? newline + 1 : end;
+    ++lineNumber;
+
+    // Ignore the trailing white space readMsg would have trimmed
+    while (lineEnd != begin && (lineEnd[-1] == '\r' || lineEnd[-1] == ' '))
+      --lineEnd;
+
+    const char *p = begin;
+    begin = next;
+
+    // The start state comes just before the game it is for
+    if (consume(p, lineEnd, "LOADSTATE ")) {
+      startState.assign(p, lineEnd);
+      continue;
+    }
+
+    if (consume(p, lineEnd, "BEGIN CHINESECHECKERS ")) {
+      games.push_back(LoggedGame());
+      game = &games.back();
+      game->line = lineNumber;
+      game->player1 = consumeWord(p, lineEnd);
+      consume(p, lineEnd, " ");
+      game->player2 = consumeWord(p, lineEnd);
+      game->startState.swap(startState);
+      startState.clear();
+      game->forfeit = Forfeit::None;
+      game->hasFinal = false;
+      game->finalLine = 0;
+      continue;
+    }
+
+    // Anything before the first BEGIN is not part of a game
+    if (game == nullptr)
+      continue;
+
+    if (consume(p, lineEnd, "MOVE FROM ")) {
+      game->moves.push_back(LoggedMove{parseMove(p, lineEnd), lineNumber});
+    } else if (consume(p, lineEnd, "FINAL ")) {
+      game->hasFinal = true;
+      game->finalLine = lineNumber;
+      game->winner = consumeWord(p, lineEnd);
+      consume(p, lineEnd, " BEATS ");
+      game->loser = consumeWord(p, lineEnd);
+    } else if (consume(p, lineEnd, "# ")) {
+      // Diagnostics explain why a game ended before it was decided
+      if (consume(p, lineEnd, "Invalid move: "))
+        game->forfeit = Forfeit::InvalidMove;
+      else if (consume(p, lineEnd, "Too long. "))
+        game->forfeit = Forfeit::TimeLimit;
+      else if (consume(p, lineEnd, "State duplicated by move: "))
+        game->forfeit = Forfeit::DuplicateState;
+      else if (consume(p, lineEnd, "Adjudicated: Race. "))
+        game->forfeit = Forfeit::RaceAdjudicated;
+      else if (consume(p, lineEnd, "Adjudicated: Ply limit "))
+        game->forfeit = Forfeit::PlyLimit;
+    }
+  }
+}
+} // namespace ChineseCheckers
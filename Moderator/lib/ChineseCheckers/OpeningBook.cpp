@@ -0,0 +1,131 @@
+//===------------------------------------------------------------*- C++ -*-===//
+#include "ChineseCheckers/OpeningBook.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ChineseCheckers {
+namespace {
+const char Magic[8] = {'C', 'C', 'B', 'O', 'O', 'K', '0', '2'};
+
+struct Header {
+  char magic[8];
+  uint64_t entries;
+};
+
+static_assert(sizeof(BookEntry) == 32, "BookEntry is an on-disk format");
+
+bool entryLess(const BookEntry &lhs, const BookEntry &rhs) {
+  return lhs.key < rhs.key;
+}
+} // namespace
+
+OpeningBook::OpeningBook() : loaded(false), entries(nullptr), count(0) {}
+
+void OpeningBook::open(const std::string &bookPath) {
+  file.close();
+  path = bookPath;
+  loaded = false;
+  entries = nullptr;
+  count = 0;
+}
+
+bool OpeningBook::load() {
+  if (loaded)
+    return entries != nullptr;
+  loaded = true;
+
+  if (path.empty() ||
+      !file.open(path, Common::MappedFile::Access::Random) ||
+      file.size() < sizeof(Header))
+    return false;
+
+  Header header;
+  std::memcpy(&header, file.begin(), sizeof(header));
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      file.size() != sizeof(Header) + header.entries * sizeof(BookEntry)) {
+    file.close();
+    return false;
+  }
+
+  entries = reinterpret_cast<const BookEntry *>(file.begin() + sizeof(Header));
+  count = header.entries;
+  return true;
+}
+
+bool OpeningBook::probe(const State &s, Move &m) {
+  if (!load())
+    return false;
+
+  Symmetry symmetry;
+  BookEntry target{};
+  target.key = canonicalKey(positionKey(s), symmetry);
+
+  auto e = std::lower_bound(entries, entries + count, target, entryLess);
+  if (e == entries + count || e->key != target.key)
+    return false;
+
+  // The move is stored for the canonical position
+  m = transformMove(Move{e->from, e->to}, symmetry);
+
+  return s.isValidMove(m);
+}
+
+size_t OpeningBook::size() {
+  load();
+  return count;
+}
+
+long OpeningBook::build(const std::string &bookPath, const PositionDB &db,
+                        uint32_t minVisits) {
+  std::vector<BookEntry> book;
+  for (const PositionStats *stats = db.begin(); stats != db.end(); ++stats) {
+    if (stats->visits < minVisits || stats->bestFrom == PositionStats::NoMove)
+      continue;
+
+    BookEntry entry{};
+    Symmetry symmetry;
+    entry.key = canonicalKey(stats->key, symmetry);
+    entry.visits = stats->visits;
+
+    Move m = transformMove(Move{stats->bestFrom, stats->bestTo}, symmetry);
+    entry.from = static_cast<uint8_t>(m.from);
+    entry.to = static_cast<uint8_t>(m.to);
+
+    book.push_back(entry);
+  }
+
+  // Symmetric positions fold together, keep the better known move
+  std::sort(book.begin(), book.end(), [](const BookEntry &lhs, const BookEntry &rhs) {
+    return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.visits > rhs.visits);
+  });
+  book.erase(std::unique(book.begin(), book.end(),
+                         [](const BookEntry &lhs, const BookEntry &rhs) {
+                           return lhs.key == rhs.key;
+                         }),
+             book.end());
+
+  std::string tmpPath = bookPath + ".tmp";
+  std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+  if (!out)
+    return -1;
+
+  Header header{};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.entries = book.size();
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(book.data()),
+            static_cast<std::streamsize>(book.size() * sizeof(BookEntry)));
+  out.close();
+
+  if (!out || std::rename(tmpPath.c_str(), bookPath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return -1;
+  }
+  return static_cast<long>(book.size());
+}
+} // namespace ChineseCheckers
@@ -0,0 +1,365 @@
+//===------------------------------------------------------------*- C++ -*-===//
+#include "ChineseCheckers/PositionDB.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ChineseCheckers {
+namespace {
+// Set in the last word of a key when player 2 is to move, as in
+// State::getSymmetricHash
+const uint64_t SideBit = uint64_t(1) << 63;
+
+const char Magic[8] = {'C', 'C', 'P', 'O', 'S', 'D', 'B', '1'};
+
+struct Header {
+  char magic[8];
+  uint64_t records;
+  uint64_t fences;
+  uint32_t blockSize;
+  uint32_t recordSize;
+};
+
+static_assert(sizeof(PositionStats) == 40, "PositionStats is an on-disk format");
+
+uint64_t getCell(const PositionKey &key, unsigned i) {
+  unsigned idx = i / PerfectHash::PosPerElt;
+  unsigned off = i % PerfectHash::PosPerElt;
+  return (key[idx] >> (2 * off)) & 0x3;
+}
+
+void setCell(PositionKey &key, unsigned i, uint64_t value) {
+  unsigned idx = i / PerfectHash::PosPerElt;
+  unsigned off = i % PerfectHash::PosPerElt;
+  key[idx] &= ~(uint64_t(0x3) << (2 * off));
+  key[idx] |= value << (2 * off);
+}
+
+bool keyLess(const PositionStats &lhs, const PositionKey &rhs) {
+  return lhs.key < rhs;
+}
+
+// Adds the results stored for key in [begin, end) to visits and wins
+void addResults(const PositionStats *begin, const PositionStats *end,
+                const PositionKey &key, uint64_t &visits,
+                std::array<uint64_t, 2> &wins) {
+  auto r = std::lower_bound(begin, end, key, keyLess);
+  if (r != end && r->key == key) {
+    visits += r->visits;
+    wins[0] += r->wins[0];
+    wins[1] += r->wins[1];
+  }
+}
+} // namespace
+
+PositionKey positionKey(const State &s) {
+  PerfectHash hash = s.getSymmetricHash(Symmetry::Identity);
+
+  PositionKey key;
+  for (size_t i = 0; i < key.size(); ++i)
+    key[i] = hash[i];
+
+  return key;
+}
+
+PositionKey childKey(const PositionKey &key, Move m) {
+  PositionKey child = key;
+  setCell(child, m.from, getCell(key, m.to));
+  setCell(child, m.to, getCell(key, m.from));
+  child.back() ^= SideBit;
+  return child;
+}
+
+PositionKey transformKey(const PositionKey &key, Symmetry symmetry) {
+  bool swap = swapsPlayers(symmetry);
+
+  PositionKey transformed{};
+  for (unsigned i = 0; i < 81; ++i) {
+    uint64_t value = getCell(key, i);
+
+    // Player 1's pieces become player 2's and the reverse
+    if (swap && value != 0)
+      value ^= 0x3;
+
+    setCell(transformed, transformCell(i, symmetry), value);
+  }
+
+  uint64_t side = key.back() & SideBit;
+  transformed.back() |= swap ? side ^ SideBit : side;
+  return transformed;
+}
+
+PositionKey canonicalKey(const PositionKey &key, Symmetry &symmetry) {
+  symmetry = Symmetry::Identity;
+  PositionKey canonical = key;
+
+  for (const auto s : {Symmetry::Transpose, Symmetry::Rotate,
+                       Symmetry::AntiTranspose}) {
+    PositionKey transformed = transformKey(key, s);
+    if (transformed < canonical) {
+      canonical = transformed;
+      symmetry = s;
+    }
+  }
+
+  return canonical;
+}
+
+bool loadPositionKey(State &s, const PositionKey &key) {
+  PerfectHash hash;
+  for (size_t i = 0; i < key.size(); ++i)
+    hash[i] = key[i];
+  hash[key.size() - 1] &= ~SideBit;
+
+  return s.loadHash(hash, (key.back() & SideBit) != 0 ? 2 : 1);
+}
+
+PositionDB::PositionDB() : records(nullptr), count(0) {}
+
+bool PositionDB::open(const std::string &path) {
+  close();
+
+  if (!file.open(path, Common::MappedFile::Access::Random) ||
+      file.size() < sizeof(Header))
+    return false;
+
+  Header header;
+  std::memcpy(&header, file.begin(), sizeof(header));
+
+  size_t expectedSize = sizeof(Header) +
+                        header.records * sizeof(PositionStats) +
+                        header.fences * sizeof(PositionKey);
+  if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+      header.recordSize != sizeof(PositionStats) ||
+      header.blockSize != BlockSize ||
+      header.fences != (header.records + BlockSize - 1) / BlockSize ||
+      file.size() != expectedSize) {
+    close();
+    return false;
+  }
+
+  count = header.records;
+  records = reinterpret_cast<const PositionStats *>(file.begin() + sizeof(Header));
+
+  fences.resize(header.fences);
+  std::memcpy(fences.data(), records + count, fences.size() * sizeof(PositionKey));
+  return true;
+}
+
+void PositionDB::close() {
+  file.close();
+  records = nullptr;
+  count = 0;
+  fences.clear();
+}
+
+size_t PositionDB::size() const {
+  return count;
+}
+
+const PositionStats *PositionDB::begin() const {
+  return records;
+}
+
+const PositionStats *PositionDB::end() const {
+  return records + count;
+}
+
+const PositionStats *PositionDB::find(const PositionKey &key) const {
+  // Find the block that would hold key
+  auto fence = std::upper_bound(fences.begin(), fences.end(), key);
+  if (fence == fences.begin())
+    return nullptr;
+  size_t block = static_cast<size_t>(fence - fences.begin()) - 1;
+
+  const PositionStats *first = records + block * BlockSize;
+  const PositionStats *last = records + std::min(count, (block + 1) * BlockSize);
+
+  auto r = std::lower_bound(first, last, key, keyLess);
+  if (r == last || r->key != key)
+    return nullptr;
+  return r;
+}
+
+const PositionStats *PositionDB::find(const State &s) const {
+  return find(positionKey(s));
+}
+
+bool PositionDB::bestMove(const State &s, Move &m) const {
+  const PositionStats *stats = find(s);
+  if (stats == nullptr || stats->bestFrom == PositionStats::NoMove)
+    return false;
+
+  m = Move{stats->bestFrom, stats->bestTo};
+  return s.isValidMove(m);
+}
+
+PositionDBBuilder::PositionDBBuilder() : reducedSize(0), gameCount(0) {}
+
+bool PositionDBBuilder::addLog(const std::string &path) {
+  Common::MappedFile file;
+  if (!file.open(path))
+    return false;
+
+  std::vector<LoggedGame> games;
+  parseGameLog(file.begin(), file.end(), games);
+  for (const auto &game : games)
+    addGame(game);
+
+  return true;
+}
+
+bool PositionDBBuilder::addGame(const LoggedGame &game) {
+  // Work out who won
+  size_t winner;
+  if (!game.hasFinal)
+    return false;
+  if (game.winner == game.player1 && game.loser == game.player2)
+    winner = 0;
+  else if (game.winner == game.player2 && game.loser == game.player1)
+    winner = 1;
+  else
+    return false;
+
+  PositionStats stats{};
+  stats.visits = 1;
+  stats.wins[winner] = 1;
+  stats.bestFrom = stats.bestTo = PositionStats::NoMove;
+
+  gs.reset();
+  if (!game.startState.empty() && !gs.loadState(game.startState))
+    return false;
+  stats.key = positionKey(gs);
+  pending.push_back(stats);
+
+  for (const auto &logged : game.moves) {
+    if (gs.gameOver() || !gs.applyMove(logged.move))
+      break;
+
+    stats.key = positionKey(gs);
+    pending.push_back(stats);
+  }
+
+  ++gameCount;
+
+  // Keep repeated positions, such as the opening, from piling up
+  if (pending.size() > 2 * reducedSize + (1u << 20))
+    reduce();
+
+  return true;
+}
+
+size_t PositionDBBuilder::games() const {
+  return gameCount;
+}
+
+void PositionDBBuilder::reduce() {
+  std::sort(pending.begin(), pending.end(),
+            [](const PositionStats &lhs, const PositionStats &rhs) {
+              return lhs.key < rhs.key;
+            });
+
+  size_t out = 0;
+  for (size_t i = 0; i < pending.size(); ++i) {
+    if (out != 0 && pending[out - 1].key == pending[i].key) {
+      pending[out - 1].visits += pending[i].visits;
+      pending[out - 1].wins[0] += pending[i].wins[0];
+      pending[out - 1].wins[1] += pending[i].wins[1];
+    } else {
+      pending[out++] = pending[i];
+    }
+  }
+
+  pending.resize(out);
+  reducedSize = out;
+}
+
+bool PositionDBBuilder::write(const std::string &path, const PositionDB &base) {
+  reduce();
+
+  // Write next to the destination so base may be the file being replaced
+  std::string tmpPath = path + ".tmp";
+  std::ofstream out(tmpPath.c_str(), std::ios::binary | std::ios::trunc);
+  if (!out)
+    return false;
+
+  Header header{};
+  std::memcpy(header.magic, Magic, sizeof(Magic));
+  header.blockSize = PositionDB::BlockSize;
+  header.recordSize = sizeof(PositionStats);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  const PositionStats *newBegin = pending.data();
+  const PositionStats *newEnd = pending.data() + pending.size();
+  const PositionStats *b = base.begin();
+  const PositionStats *n = newBegin;
+
+  std::vector<PositionKey> fences;
+  std::set<Move> moves;
+  while (b != base.end() || n != newEnd) {
+    // Merge the next key from either side
+    PositionStats stats;
+    if (n == newEnd || (b != base.end() && b->key < n->key)) {
+      stats = *b++;
+    } else if (b == base.end() || n->key < b->key) {
+      stats = *n++;
+    } else {
+      stats = *b++;
+      stats.visits += n->visits;
+      stats.wins[0] += n->wins[0];
+      stats.wins[1] += n->wins[1];
+      ++n;
+    }
+
+    // Pick the reached continuation that did best for the player to move,
+    // smoothed so a single lucky game does not outweigh a long record
+    stats.bestFrom = stats.bestTo = PositionStats::NoMove;
+    if (loadPositionKey(gs, stats.key)) {
+      size_t mover = static_cast<size_t>(gs.getCurrentPlayer() - 1);
+      double bestScore = -1;
+      gs.getMoves(moves);
+      for (const auto m : moves) {
+        PositionKey child = childKey(stats.key, m);
+        uint64_t visits = 0;
+        std::array<uint64_t, 2> wins{{0, 0}};
+        addResults(base.begin(), base.end(), child, visits, wins);
+        addResults(newBegin, newEnd, child, visits, wins);
+        if (visits == 0)
+          continue;
+
+        double score = static_cast<double>(wins[mover] + 1) /
+                       static_cast<double>(visits + 2);
+        if (score > bestScore) {
+          bestScore = score;
+          stats.bestFrom = static_cast<uint8_t>(m.from);
+          stats.bestTo = static_cast<uint8_t>(m.to);
+        }
+      }
+    }
+
+    if (header.records % PositionDB::BlockSize == 0)
+      fences.push_back(stats.key);
+    out.write(reinterpret_cast<const char *>(&stats), sizeof(stats));
+    ++header.records;
+  }
+
+  out.write(reinterpret_cast<const char *>(fences.data()),
+            static_cast<std::streamsize>(fences.size() * sizeof(PositionKey)));
+
+  header.fences = fences.size();
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.close();
+
+  if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  return true;
+}
+} // namespace ChineseCheckers
@@ -4,10 +4,10 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdlib>
 #include <iomanip>
 #include <iterator>
 #include <set>
-#include <sstream>
 #include <string>
 #include <vector>
 
@@ -65,6 +65,170 @@ std::ostream &operator<<(std::ostream &out, const PerfectHash &h) {
   return out;
 }
 
+PositionRank::PositionRank() : hi(0), lo(0) {}
+
+PositionRank::PositionRank(uint64_t high, uint64_t low) : hi(high), lo(low) {}
+
+uint64_t PositionRank::high() const {
+  return hi;
+}
+
+uint64_t PositionRank::low() const {
+  return lo;
+}
+
+void PositionRank::write(uint8_t *out) const {
+  for (unsigned i = 0; i < NumBytes; ++i)
+    out[i] = static_cast<uint8_t>(i < 8 ? lo >> (8 * i) : hi >> (8 * (i - 8)));
+}
+
+PositionRank PositionRank::read(const uint8_t *in) {
+  PositionRank rank;
+  for (unsigned i = 0; i < NumBytes; ++i) {
+    if (i < 8)
+      rank.lo |= static_cast<uint64_t>(in[i]) << (8 * i);
+    else
+      rank.hi |= static_cast<uint64_t>(in[i]) << (8 * (i - 8));
+  }
+  return rank;
+}
+
+bool operator==(const PositionRank &lhs, const PositionRank &rhs) {
+  return lhs.hi == rhs.hi && lhs.lo == rhs.lo;
+}
+
+bool operator<(const PositionRank &lhs, const PositionRank &rhs) {
+  return lhs.hi < rhs.hi || (lhs.hi == rhs.hi && lhs.lo < rhs.lo);
+}
+
+std::ostream &operator<<(std::ostream &out, const PositionRank &r) {
+  std::ios state(nullptr);
+  state.copyfmt(out);
+
+  out << std::hex << r.hi << std::setw(16) << std::setfill('0') << r.lo;
+
+  out.copyfmt(state);
+  return out;
+}
+
+namespace {
+// Pieces each player has
+const unsigned NumPieces = 10;
+
+typedef std::array<std::array<uint64_t, NumPieces + 1>, 82> BinomialTable;
+
+// binomials()[n][k] is n choose k
+const BinomialTable &binomials() {
+  static const BinomialTable table = [] {
+    BinomialTable t{};
+    t[0][0] = 1;
+    for (unsigned n = 1; n < t.size(); ++n) {
+      t[n][0] = 1;
+      for (unsigned k = 1; k <= NumPieces; ++k)
+        t[n][k] = t[n - 1][k - 1] + t[n - 1][k];
+    }
+    return t;
+  }();
+  return table;
+}
+
+// Ways to place player 1's and then player 2's pieces
+const uint64_t Player1Placements = 1878392407320ull; // 81 choose 10
+const uint64_t Player2Placements = 461738052776ull;  // 71 choose 10
+
+// Sets hi:lo to a * b
+void multiply(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+  const uint64_t mask = 0xffffffff;
+  uint64_t p00 = (a & mask) * (b & mask);
+  uint64_t p01 = (a & mask) * (b >> 32);
+  uint64_t p10 = (a >> 32) * (b & mask);
+  uint64_t p11 = (a >> 32) * (b >> 32);
+
+  uint64_t mid = (p00 >> 32) + (p01 & mask) + (p10 & mask);
+  lo = (p00 & mask) | (mid << 32);
+  hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+
+// Marks the cells of the combination with colex rank among cells with value
+void unrankCombination(uint64_t rank, const std::array<unsigned, 81> &cells,
+                       unsigned numCells, int value, std::array<int, 81> &board) {
+  const BinomialTable &choose = binomials();
+
+  // Each piece sits on the last cell whose binomial still fits in the rank,
+  // and those cells only move down, so this walks the cells once
+  unsigned c = numCells;
+  for (unsigned k = NumPieces; k > 0; --k) {
+    do {
+      --c;
+    } while (choose[c][k] > rank);
+
+    rank -= choose[c][k];
+    board[cells[c]] = value;
+  }
+}
+} // namespace
+
+namespace {
+// The cells each player must fill to win, the other player's home
+const std::array<unsigned, 10> Player1Goal = {{53, 61, 62, 69, 70, 71, 77, 78, 79, 80}};
+const std::array<unsigned, 10> Player2Goal = {{0, 1, 2, 3, 9, 10, 11, 18, 19, 27}};
+
+const std::array<unsigned, 10> &goalCells(int player) {
+  return player == 1 ? Player1Goal : Player2Goal;
+}
+
+bool isGoalCell(int player, unsigned cell) {
+  const auto &goal = goalCells(player);
+  return std::find(goal.begin(), goal.end(), cell) != goal.end();
+}
+
+// Single steps between two cells on an empty board. Neighbours differ by one
+// row, one column, or one row down and one column left
+int stepDistance(unsigned from, unsigned to) {
+  int rows = static_cast<int>(to / 9) - static_cast<int>(from / 9);
+  int cols = static_cast<int>(to % 9) - static_cast<int>(from % 9);
+  return std::max(std::max(std::abs(rows), std::abs(cols)), std::abs(rows + cols));
+}
+
+// Set in the last element of a symmetric hash when player 2 is to move
+const uint64_t SideBit = uint64_t(1) << 63;
+
+const std::array<Symmetry, 4> Symmetries = {
+    {Symmetry::Identity, Symmetry::Transpose, Symmetry::Rotate,
+     Symmetry::AntiTranspose}};
+
+typedef std::array<std::array<unsigned, 81>, 4> SymmetryTable;
+
+// symmetryTable()[s][i] is the cell symmetry s maps cell i to
+const SymmetryTable &symmetryTable() {
+  static const SymmetryTable table = [] {
+    SymmetryTable t;
+    for (unsigned i = 0; i < 81; ++i) {
+      unsigned transposed = (i % 9) * 9 + i / 9;
+      t[static_cast<size_t>(Symmetry::Identity)][i] = i;
+      t[static_cast<size_t>(Symmetry::Transpose)][i] = transposed;
+      t[static_cast<size_t>(Symmetry::Rotate)][i] = 80 - i;
+      t[static_cast<size_t>(Symmetry::AntiTranspose)][i] = 80 - transposed;
+    }
+    return t;
+  }();
+  return table;
+}
+} // namespace
+
+bool swapsPlayers(Symmetry s) {
+  return s == Symmetry::Rotate || s == Symmetry::AntiTranspose;
+}
+
+unsigned transformCell(unsigned cell, Symmetry s) {
+  assert(cell < 81 && "OOB Index");
+  return symmetryTable()[static_cast<size_t>(s)][cell];
+}
+
+Move transformMove(Move m, Symmetry s) {
+  return {transformCell(m.from, s), transformCell(m.to, s)};
+}
+
 State::State() {
   reset();
 }
@@ -147,36 +311,126 @@ void State::reset() {
   addStateAsSeen();
 }
 
-bool State::loadState(const std::string &newState) {
-  auto tokenized = Common::split(newState);
+namespace {
+// Characters of a dump in each format
+const size_t TokensSize = 163;
+const size_t CompactSize = 2 * State::PackedBytes;
+
+const char HexDigits[] = "0123456789abcdef";
+
+// Returns the value of a hexadecimal digit of either case, or -1
+int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+} // namespace
+
+bool State::loadState(Common::StringRef newState) {
+  size_t length = newState.size();
+  // As with split, a space after the last token ends it
+  if (length == TokensSize + 1 && newState[TokensSize] == ' ')
+    length = TokensSize;
+
+  if (length == CompactSize) {
+    uint8_t packed[PackedBytes];
+    for (size_t i = 0; i < PackedBytes; ++i) {
+      int high = hexValue(newState[2 * i]);
+      int low = hexValue(newState[2 * i + 1]);
+      if (high < 0 || low < 0)
+        return false;
+      packed[i] = static_cast<uint8_t>(high * 16 + low);
+    }
+    return loadPacked(packed);
+  }
 
-  // Ensure the length
-  if (tokenized.size() != 82)
+  // Ensure the length, one character for each of the 82 tokens and a space
+  // between them
+  if (length != TokensSize)
     return false;
+  for (size_t i = 1; i < length; i += 2) {
+    if (newState[i] != ' ')
+      return false;
+  }
 
   // Validate first item, whose turn it is
-  if (tokenized[0] != "1" && tokenized[0] != "2")
+  if (newState[0] != '1' && newState[0] != '2')
     return false;
-  currentPlayer = std::stoi(tokenized[0]);
+  int player = newState[0] - '0';
 
   // Ensure rest of tokens are valid
-  for(size_t i = 1, e = tokenized.size(); i != e; ++i) {
-    int val = std::stoi(tokenized[i]);
-    if (0 <= val && val <= 2)
-      board[i - 1] = val;
-    else
+  std::array<int, 81> newBoard;
+  for (size_t i = 0; i < newBoard.size(); ++i) {
+    char val = newState[2 * i + 2];
+    if (val < '0' || val > '2')
       return false;
+    newBoard[i] = val - '0';
   }
+
+  board = newBoard;
+  currentPlayer = player;
+
+  // The history leading here is unknown
+  statesSeen.clear();
+  duplicatedStates.clear();
+  addStateAsSeen();
   return true;
 }
 
-std::string State::dumpState() const {
-  std::stringstream out;
-  out << currentPlayer;
-  for (const auto i : board)
-    out << " " << i;
+std::string State::dumpState(Format format) const {
+  char out[MaxDumpSize];
+  return std::string(out, dumpState(out, format));
+}
+
+size_t State::dumpState(char *out, Format format) const {
+  if (format == Format::Compact) {
+    uint8_t packed[PackedBytes];
+    writePacked(packed);
+    for (size_t i = 0; i < PackedBytes; ++i) {
+      out[2 * i] = HexDigits[packed[i] >> 4];
+      out[2 * i + 1] = HexDigits[packed[i] & 15];
+    }
+    return CompactSize;
+  }
 
-  return out.str();
+  out[0] = static_cast<char>('0' + currentPlayer);
+  for (size_t i = 0; i < board.size(); ++i) {
+    out[2 * i + 1] = ' ';
+    out[2 * i + 2] = static_cast<char>('0' + board[i]);
+  }
+  return TokensSize;
+}
+
+void State::writePacked(uint8_t *out) const {
+  std::fill(out, out + PackedBytes, 0);
+  out[0] = static_cast<uint8_t>(currentPlayer);
+  for (unsigned i = 0; i < board.size(); ++i)
+    out[1 + i / 4] |= static_cast<uint8_t>(board[i] << (2 * (i % 4)));
+}
+
+bool State::loadPacked(const uint8_t *in) {
+  if (in[0] != 1 && in[0] != 2)
+    return false;
+
+  std::array<int, 81> newBoard;
+  for (unsigned i = 0; i < newBoard.size(); ++i) {
+    int cell = (in[1 + i / 4] >> (2 * (i % 4))) & 3;
+    if (cell == 3)
+      return false;
+    newBoard[i] = cell;
+  }
+
+  board = newBoard;
+  currentPlayer = in[0];
+
+  statesSeen.clear();
+  duplicatedStates.clear();
+  addStateAsSeen();
+  return true;
 }
 
 void State::getMovesSingleStep(std::set<Move> &moves, unsigned from) const {
@@ -285,29 +539,30 @@ bool State::isValidMove(const Move &m) const {
   return found;
 }
 
-Move State::translateToLocal(const std::vector<std::string> &tokens) const {
+Move State::translateToLocal(const Common::Tokens &tokens) const {
   // The numbers in the MOVE command sent by the moderator is already in the
   // format we need
-  try {
-    return Move{static_cast<unsigned>(std::stoi(tokens[2])),
-        static_cast<unsigned>(std::stoi(tokens[4]))};
-  } catch (std::invalid_argument e) {
+  Move m;
+  if (Common::parseUnsigned(tokens[2], m.from) != Common::ParseError::None ||
+      Common::parseUnsigned(tokens[4], m.to) != Common::ParseError::None)
     return Move{0, 0};
-  } catch (std::out_of_range e) {
-    return Move{0, 0};
-  }
-
+  return m;
 }
 
 std::string State::listMoves() const {
+  char buffer[1024];
+  Common::FormatBuffer out(buffer);
+  return listMoves(out).str();
+}
+
+Common::StringRef State::listMoves(Common::FormatBuffer &out) const {
   std::set<Move> moves;
   getMoves(moves);
 
-  std::stringstream ss;
+  size_t before = out.size();
   for (const auto i : moves)
-    ss << i.from << ", " << i.to << "; ";
-
-  return ss.str();
+    out << i.from << ", " << i.to << "; ";
+  return out.str().drop(before);
 }
 
 PerfectHash State::getHash() const {
@@ -317,16 +572,247 @@ PerfectHash State::getHash() const {
     unsigned idx = i / PerfectHash::PosPerElt;
     unsigned off = i % PerfectHash::PosPerElt;
 
-    hash[idx] |= static_cast<uint64_t>(board[i] & 0x3) << off;
+    hash[idx] |= static_cast<uint64_t>(board[i] & 0x3) << (2 * off);
+  }
+
+  return hash;
+}
+
+bool State::loadHash(const PerfectHash &hash, int player) {
+  if (player != 1 && player != 2)
+    return false;
+
+  std::array<int, 81> newBoard;
+  for (unsigned i = 0; i < 81; ++i) {
+    unsigned idx = i / PerfectHash::PosPerElt;
+    unsigned off = i % PerfectHash::PosPerElt;
+
+    newBoard[i] = static_cast<int>((hash[idx] >> (2 * off)) & 0x3);
+    if (newBoard[i] == 3)
+      return false;
+  }
+
+  board = newBoard;
+  currentPlayer = player;
+
+  // The history leading here is unknown
+  statesSeen.clear();
+  duplicatedStates.clear();
+  addStateAsSeen();
+  return true;
+}
+
+PerfectHash State::getSymmetricHash(Symmetry symmetry) const {
+  const auto &cells = symmetryTable()[static_cast<size_t>(symmetry)];
+  bool swap = swapsPlayers(symmetry);
+
+  PerfectHash hash;
+  for (unsigned i = 0; i < 81; ++i) {
+    int value = board[i];
+    if (swap && value != 0)
+      value = 3 - value;
+
+    unsigned idx = cells[i] / PerfectHash::PosPerElt;
+    unsigned off = cells[i] % PerfectHash::PosPerElt;
+    hash[idx] |= static_cast<uint64_t>(value & 0x3) << (2 * off);
   }
 
+  int player = swap ? 3 - currentPlayer : currentPlayer;
+  if (player == 2)
+    hash[PerfectHash::NumElts - 1] |= SideBit;
+
   return hash;
 }
 
+PerfectHash State::getCanonicalHash(Symmetry &symmetry) const {
+  symmetry = Symmetry::Identity;
+  PerfectHash canonical = getSymmetricHash(symmetry);
+
+  for (const auto s : Symmetries) {
+    PerfectHash hash = getSymmetricHash(s);
+    if (hash < canonical) {
+      canonical = hash;
+      symmetry = s;
+    }
+  }
+
+  return canonical;
+}
+
+int State::getCurrentPlayer() const {
+  return currentPlayer;
+}
+
+bool State::getRank(PositionRank &rank) const {
+  const BinomialTable &choose = binomials();
+
+  // Colex rank of player 1's cells, and of player 2's among the others
+  uint64_t rank1 = 0, rank2 = 0;
+  unsigned pieces1 = 0, pieces2 = 0, others = 0;
+  for (unsigned i = 0; i < 81; ++i) {
+    if (board[i] == 1) {
+      if (pieces1 == NumPieces)
+        return false;
+      rank1 += choose[i][++pieces1];
+    } else {
+      if (board[i] == 2) {
+        if (pieces2 == NumPieces)
+          return false;
+        rank2 += choose[others][++pieces2];
+      }
+      ++others;
+    }
+  }
+
+  if (pieces1 != NumPieces || pieces2 != NumPieces)
+    return false;
+
+  // ((rank1 * Player2Placements) + rank2) * 2 + player to move
+  uint64_t hi, lo;
+  multiply(rank1, Player2Placements, hi, lo);
+  lo += rank2;
+  hi += lo < rank2 ? 1 : 0;
+
+  hi = (hi << 1) | (lo >> 63);
+  lo = (lo << 1) | static_cast<uint64_t>(currentPlayer - 1);
+
+  rank = PositionRank(hi, lo);
+  return true;
+}
+
+bool State::loadRank(const PositionRank &rank) {
+  int player = static_cast<int>(rank.low() & 1) + 1;
+  uint64_t hi = rank.high() >> 1;
+  uint64_t lo = (rank.low() >> 1) | (rank.high() << 63);
+
+  // Anything at or above 2^80 is out of range, and below it the quotient
+  // fits in 64 bits
+  if ((hi >> 16) != 0)
+    return false;
+
+  // Long division of hi:lo by Player2Placements, 16 bits at a time so the
+  // running remainder never overflows
+  uint64_t rank1 = 0, rank2 = 0;
+  for (unsigned chunk = 8; chunk > 0; --chunk) {
+    unsigned shift = 16 * (chunk - 1);
+    uint64_t digits = (shift >= 64 ? hi >> (shift - 64) : lo >> shift) & 0xffff;
+    uint64_t current = (rank2 << 16) | digits;
+    rank1 = (rank1 << 16) | (current / Player2Placements);
+    rank2 = current % Player2Placements;
+  }
+
+  if (rank1 >= Player1Placements)
+    return false;
+
+  std::array<unsigned, 81> cells;
+  for (unsigned i = 0; i < 81; ++i)
+    cells[i] = i;
+
+  std::array<int, 81> newBoard{};
+  unrankCombination(rank1, cells, 81, 1, newBoard);
+
+  // Player 2's rank indexes the cells player 1 left empty
+  unsigned others = 0;
+  for (unsigned i = 0; i < 81; ++i) {
+    if (newBoard[i] == 0)
+      cells[others++] = i;
+  }
+  unrankCombination(rank2, cells, others, 2, newBoard);
+
+  board = newBoard;
+  currentPlayer = player;
+
+  // The history leading here is unknown
+  statesSeen.clear();
+  duplicatedStates.clear();
+  addStateAsSeen();
+  return true;
+}
+
 bool State::seenDuplicatedState() const {
   return !duplicatedStates.empty();
 }
 
+int State::raceCount(int player) const {
+  std::vector<unsigned> pieces;
+  for (unsigned i = 0; i < 81; ++i) {
+    if (board[i] == player)
+      pieces.push_back(i);
+  }
+  if (pieces.size() != NumPieces)
+    return -1;
+
+  // best[mask] is the fewest steps taking the first popcount(mask) pieces to
+  // the goal cells in mask
+  const auto &goal = goalCells(player);
+  std::vector<int> best(1u << NumPieces, -1);
+  best[0] = 0;
+  for (unsigned mask = 0; mask < best.size(); ++mask) {
+    if (best[mask] < 0)
+      continue;
+    unsigned placed = 0;
+    for (unsigned bits = mask; bits != 0; bits &= bits - 1)
+      ++placed;
+    if (placed == NumPieces)
+      continue;
+
+    for (unsigned cell = 0; cell < NumPieces; ++cell) {
+      if (mask & (1u << cell))
+        continue;
+      int steps = best[mask] + stepDistance(pieces[placed], goal[cell]);
+      int &next = best[mask | (1u << cell)];
+      if (next < 0 || steps < next)
+        next = steps;
+    }
+  }
+  return best.back();
+}
+
+bool State::disengaged() const {
+  // Player 1 heads for higher row + column, player 2 for lower
+  int player1Last = 16, player2First = 0;
+  for (int i = 0; i < 81; ++i) {
+    int progress = i / 9 + i % 9;
+    if (board[static_cast<size_t>(i)] == 1)
+      player1Last = std::min(player1Last, progress);
+    else if (board[static_cast<size_t>(i)] == 2)
+      player2First = std::max(player2First, progress);
+  }
+  return player1Last > player2First;
+}
+
+int State::raceWinner() const {
+  if (!disengaged())
+    return -1;
+
+  for (int player : {1, 2}) {
+    int other = player == 1 ? 2 : 1;
+    int steps = raceCount(player);
+    if (steps < 0)
+      return -1;
+
+    // Every piece outside the goal takes at least one move, jumps or not
+    int otherMoves = 0;
+    for (unsigned i = 0; i < 81; ++i) {
+      if (board[i] == other && !isGoalCell(other, i))
+        ++otherMoves;
+    }
+
+    // Moving first wins a tie
+    if (steps < otherMoves || (steps == otherMoves && currentPlayer == player))
+      return player;
+  }
+  return -1;
+}
+
+int State::raceLeader() const {
+  int player1 = raceCount(1);
+  int player2 = raceCount(2);
+  if (player1 == player2)
+    return currentPlayer;
+  return player1 < player2 ? 1 : 2;
+}
+
 void State::swapTurn() {
   currentPlayer = currentPlayer == 1 ?  2 : 1;
 }
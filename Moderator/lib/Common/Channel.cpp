@@ -0,0 +1,166 @@
+#include "Common/Channel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <string>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "Common/Profile.h"
+#include "Common/Timer.h"
+
+namespace Common {
+namespace {
+// Ring sizes are powers of 2 so positions wrap with a mask
+const size_t InitialRing = 4096;
+// Queued output is written once there is this much of it
+const size_t MaxOutbox = 64 * 1024;
+} // namespace
+
+Channel::Channel(int inFd, int outFd)
+    : in(inFd), out(outFd), ring(InitialRing), head(0), tail(0), scanned(0),
+      ended(false), frameSize(nullptr) {}
+
+Channel &Channel::standard() {
+  static Channel channel(STDIN_FILENO, STDOUT_FILENO);
+  return channel;
+}
+
+bool Channel::readLine(std::string &line, double timeout) {
+  typedef std::chrono::steady_clock Clock;
+  bool forever = timeout < 0.0;
+  Clock::time_point deadline =
+      Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                         std::chrono::duration<double>(forever ? 0.0 : timeout));
+
+  for (;;) {
+    if (takeLine(line))
+      return true;
+
+    // Whatever was sent is what the other side is answering
+    flush();
+
+    int wait = -1;
+    if (!forever) {
+      std::chrono::duration<double> left = deadline - Clock::now();
+      wait = Common::pollTimeout(left.count());
+    }
+
+    pollfd ready{in, POLLIN, 0};
+    int polled = poll(&ready, 1, wait);
+    if (polled == 0)
+      return false;
+    if (polled < 0 && errno != EINTR)
+      ended = true;
+    else if (polled > 0)
+      fill();
+  }
+}
+
+void Channel::setFrameSize(FrameSize size) {
+  frameSize = size;
+  // What was scanned for a newline may have been a frame
+  scanned = head;
+}
+
+void Channel::write(StringRef line) {
+  outbox.append(line.data(), line.size());
+  outbox += '\n';
+  if (outbox.size() >= MaxOutbox)
+    flush();
+}
+
+void Channel::writeFrame(StringRef frame) {
+  outbox.append(frame.data(), frame.size());
+  if (outbox.size() >= MaxOutbox)
+    flush();
+}
+
+bool Channel::flush() {
+  size_t written = 0;
+  while (written < outbox.size()) {
+    ssize_t wrote = ::write(out, outbox.data() + written, outbox.size() - written);
+    if (wrote < 0 && (errno == EINTR || errno == EAGAIN))
+      continue;
+    if (wrote <= 0) {
+      outbox.clear();
+      return false;
+    }
+    written += static_cast<size_t>(wrote);
+  }
+  outbox.clear();
+  return true;
+}
+
+bool Channel::takeLine(std::string &line) {
+  size_t mask = ring.size() - 1;
+  size_t frame = head != tail && frameSize != nullptr ? frameSize(ring[head & mask]) : 0;
+  if (frame > 0) {
+    if (tail - head < frame && !ended)
+      return false;
+
+    copyOut(line, std::min(frame, tail - head));
+    head += line.size();
+    scanned = head;
+    return true;
+  }
+
+  size_t lineEnd = std::max(head, scanned);
+  while (lineEnd != tail && ring[lineEnd & mask] != '\n')
+    ++lineEnd;
+  scanned = lineEnd;
+
+  if (lineEnd == tail && !ended)
+    return false;
+
+  copyOut(line, lineEnd - head);
+  head = lineEnd == tail ? tail : lineEnd + 1;
+  scanned = head;
+  Common::rtrim(line);
+  return true;
+}
+
+void Channel::copyOut(std::string &line, size_t length) const {
+  // The line may wrap around the end of the ring
+  line.clear();
+  size_t first = head & (ring.size() - 1);
+  size_t beforeWrap = std::min(length, ring.size() - first);
+  line.append(&ring[first], beforeWrap);
+  line.append(ring.data(), length - beforeWrap);
+}
+
+void Channel::fill() {
+  size_t used = tail - head;
+  if (used == ring.size()) {
+    // A line longer than the ring, unwrap it into one twice the size
+    std::vector<char> bigger(ring.size() * 2);
+    size_t mask = ring.size() - 1;
+    for (size_t i = 0; i < used; ++i)
+      bigger[i] = ring[(head + i) & mask];
+    ring.swap(bigger);
+    scanned -= head;
+    head = 0;
+    tail = used;
+  }
+
+  // Read into the free space up to the end of the ring, the rest of it is
+  // filled on the next call
+  size_t mask = ring.size() - 1;
+  size_t start = tail & mask;
+  size_t space = std::min(ring.size() - used, ring.size() - start);
+  ssize_t got;
+  {
+    PROFILE_ZONE(Read);
+    got = read(in, &ring[start], space);
+  }
+  if (got < 0 && (errno == EINTR || errno == EAGAIN))
+    return;
+  if (got <= 0) {
+    ended = true;
+    return;
+  }
+  tail += static_cast<size_t>(got);
+}
+} // namespace Common
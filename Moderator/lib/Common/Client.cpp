@@ -1,16 +1,33 @@
 #include "Common/Client.h"
 
-#include <iostream>
 #include <string>
 
-#include "Common/String.h"
+#include "Common/Channel.h"
 
 namespace Common {
 std::string readMsg() {
   std::string msg;
-  std::getline(std::cin, msg);
-  msg = Common::rtrim(msg);
+  readMsg(msg, -1.0);
   return msg;
 }
 
+bool readMsg(std::string &msg, double timeout) {
+  return Channel::standard().readLine(msg, timeout);
+}
+
+void sendMsg(StringRef msg) {
+  Channel::standard().write(msg);
+}
+
+void sendFrame(StringRef frame) {
+  Channel::standard().writeFrame(frame);
+}
+
+void flushMsgs() {
+  Channel::standard().flush();
+}
+
+void readFrames(FrameSize frameSize) {
+  Channel::standard().setFrameSize(frameSize);
+}
 } // namespace Common
@@ -0,0 +1,44 @@
+#include "Common/EchoQueue.h"
+
+#include <cstring>
+
+namespace Common {
+EchoQueue::EchoQueue() : head(0) {}
+
+void EchoQueue::push(StringRef msg) {
+  pending.push_back({hash(msg), msg.size(), arena.size()});
+  arena.append(msg.data(), msg.size());
+}
+
+bool EchoQueue::pop(StringRef msg) {
+  if (empty())
+    return false;
+
+  const Echo &oldest = pending[head];
+  if (oldest.hash != hash(msg) || oldest.length != msg.size() ||
+      std::memcmp(arena.data() + oldest.offset, msg.data(), msg.size()) != 0)
+    return false;
+
+  ++head;
+  // Start over at the front, keeping the storage
+  if (empty())
+    clear();
+  return true;
+}
+
+void EchoQueue::clear() {
+  pending.clear();
+  arena.clear();
+  head = 0;
+}
+
+uint64_t EchoQueue::hash(StringRef msg) {
+  // FNV-1a
+  uint64_t h = 14695981039346656037ull;
+  for (char c : msg) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+} // namespace Common
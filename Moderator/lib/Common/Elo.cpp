@@ -0,0 +1,78 @@
+//===------------------------------------------------------------*- C++ -*-===//
+#include "Common/Elo.h"
+
+#include <cmath>
+#include <limits>
+
+namespace Common {
+namespace {
+// Two sided 95% quantile of the normal distribution
+const double Z95 = 1.959963984540054;
+} // namespace
+
+double eloFromScore(double score) {
+  return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+double scoreFromElo(double elo) {
+  return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+EloEstimate estimateElo(unsigned wins, unsigned draws, unsigned losses) {
+  const double infinity = std::numeric_limits<double>::infinity();
+
+  if (wins + draws + losses == 0)
+    return EloEstimate{0.0, infinity};
+  double games = static_cast<double>(wins + draws + losses);
+
+  double w = static_cast<double>(wins) / games;
+  double d = static_cast<double>(draws) / games;
+  double l = static_cast<double>(losses) / games;
+  double score = w + d / 2;
+
+  if (wins == 0 && draws == 0)
+    return EloEstimate{-infinity, infinity};
+  if (losses == 0 && draws == 0)
+    return EloEstimate{infinity, infinity};
+
+  // Variance of a single game's score, and from it of the mean score
+  double variance = w * std::pow(1.0 - score, 2) + d * std::pow(0.5 - score, 2) +
+                    l * std::pow(score, 2);
+  double deviation = std::sqrt(variance / games);
+
+  double low = score - Z95 * deviation;
+  double high = score + Z95 * deviation;
+  if (low <= 0.0 || high >= 1.0)
+    return EloEstimate{eloFromScore(score), infinity};
+
+  return EloEstimate{eloFromScore(score),
+                     (eloFromScore(high) - eloFromScore(low)) / 2};
+}
+
+double sprtLLR(unsigned wins, unsigned draws, unsigned losses, double elo0,
+               double elo1) {
+  if (wins + draws + losses == 0)
+    return 0.0;
+  // A record of only wins or only losses would have no variance and never
+  // end the test, so it gets half a game of each
+  double games = static_cast<double>(wins + draws + losses) + 1.0;
+
+  double w = (static_cast<double>(wins) + 0.5) / games;
+  double d = static_cast<double>(draws) / games;
+  double l = (static_cast<double>(losses) + 0.5) / games;
+  double score = w + d / 2;
+
+  double variance = w * std::pow(1.0 - score, 2) + d * std::pow(0.5 - score, 2) +
+                    l * std::pow(score, 2);
+
+  double score0 = scoreFromElo(elo0);
+  double score1 = scoreFromElo(elo1);
+  return games * (score1 - score0) * (2 * score - score0 - score1) /
+         (2 * variance);
+}
+
+void sprtBounds(double alpha, double beta, double &lower, double &upper) {
+  lower = std::log(beta / (1 - alpha));
+  upper = std::log((1 - beta) / alpha);
+}
+} // namespace Common
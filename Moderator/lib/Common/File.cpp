@@ -0,0 +1,93 @@
+//===------------------------------------------------------------*- C++ -*-===//
+#include "Common/File.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Common {
+MappedFile::MappedFile() : fd(-1), data(nullptr), length(0) {}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string &path, Access access) {
+  close();
+
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+    close();
+    return false;
+  }
+
+  // mmap refuses zero length mappings, an empty file is just an empty range
+  length = static_cast<size_t>(info.st_size);
+  if (length == 0)
+    return true;
+
+  data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    data = nullptr;
+    close();
+    return false;
+  }
+
+  madvise(data, length,
+          access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+  return true;
+}
+
+void MappedFile::close() {
+  if (data != nullptr)
+    munmap(data, length);
+  if (fd >= 0)
+    ::close(fd);
+
+  fd = -1;
+  data = nullptr;
+  length = 0;
+}
+
+const char *MappedFile::begin() const {
+  return static_cast<const char *>(data);
+}
+
+const char *MappedFile::end() const {
+  return begin() + length;
+}
+
+size_t MappedFile::size() const {
+  return length;
+}
+
+bool listFiles(const std::string &directory, std::vector<std::string> &files) {
+  DIR *dir = opendir(directory.c_str());
+  if (dir == nullptr)
+    return false;
+
+  std::vector<std::string> found;
+  while (struct dirent *entry = readdir(dir)) {
+    std::string path = directory + "/" + entry->d_name;
+
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+      found.push_back(path);
+  }
+  closedir(dir);
+
+  std::sort(found.begin(), found.end());
+  files.insert(files.end(), found.begin(), found.end());
+  return true;
+}
+} // namespace Common
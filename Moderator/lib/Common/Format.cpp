@@ -0,0 +1,117 @@
+#include "Common/Format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace Common {
+namespace {
+// Digits of the largest unsigned long long
+const size_t MaxDigits = 20;
+
+// Writes the digits of value ending just before end, returning where they
+// start
+char *writeDigits(char *end, unsigned long long value) {
+  do {
+    *--end = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+} // namespace
+
+FormatBuffer::FormatBuffer(char *buffer, size_t capacity)
+    : start(buffer), next(buffer), limit(buffer + capacity) {}
+
+FormatBuffer &FormatBuffer::operator<<(StringRef text) {
+  reserve(text.size());
+  std::memcpy(next, text.data(), text.size());
+  next += text.size();
+  return *this;
+}
+
+FormatBuffer &FormatBuffer::operator<<(char c) {
+  reserve(1);
+  *next++ = c;
+  return *this;
+}
+
+FormatBuffer &FormatBuffer::operator<<(int value) { return writeSigned(value); }
+
+FormatBuffer &FormatBuffer::operator<<(unsigned value) { return writeUnsigned(value); }
+
+FormatBuffer &FormatBuffer::operator<<(long value) { return writeSigned(value); }
+
+FormatBuffer &FormatBuffer::operator<<(unsigned long value) {
+  return writeUnsigned(value);
+}
+
+FormatBuffer &FormatBuffer::operator<<(long long value) { return writeSigned(value); }
+
+FormatBuffer &FormatBuffer::operator<<(unsigned long long value) {
+  return writeUnsigned(value);
+}
+
+FormatBuffer &FormatBuffer::operator<<(double value) {
+  char digits[32];
+  int length = std::snprintf(digits, sizeof(digits), "%g", value);
+  return *this << StringRef(digits, static_cast<size_t>(std::max(0, length)));
+}
+
+FormatBuffer &FormatBuffer::padded(long long value, unsigned width) {
+  char digits[MaxDigits + 1];
+  char *end = digits + sizeof(digits);
+  unsigned long long magnitude = value < 0 ? 0 - static_cast<unsigned long long>(value)
+                                           : static_cast<unsigned long long>(value);
+  char *first = writeDigits(end, magnitude);
+  if (value < 0)
+    *--first = '-';
+
+  size_t length = static_cast<size_t>(end - first);
+  reserve(std::max<size_t>(width, length));
+  for (size_t i = length; i < width; ++i)
+    *next++ = ' ';
+  std::memcpy(next, first, length);
+  next += length;
+  return *this;
+}
+
+FormatBuffer &FormatBuffer::fixed(double value, int precision) {
+  char digits[64];
+  int length = std::snprintf(digits, sizeof(digits), "%.*f", precision, value);
+  // Huge values do not fit, write them the usual way
+  if (length < 0 || static_cast<size_t>(length) >= sizeof(digits))
+    return *this << value;
+  return *this << StringRef(digits, static_cast<size_t>(length));
+}
+
+void FormatBuffer::reserve(size_t more) {
+  size_t used = size();
+  if (more <= static_cast<size_t>(limit - next))
+    return;
+
+  // Move to the heap, or grow it, at least doubling the room
+  size_t capacity = std::max(2 * static_cast<size_t>(limit - start), used + more);
+  if (start != spill.data())
+    spill.assign(start, used);
+  spill.resize(capacity);
+  start = &spill[0];
+  next = start + used;
+  limit = start + capacity;
+}
+
+FormatBuffer &FormatBuffer::writeSigned(long long value) {
+  if (value >= 0)
+    return writeUnsigned(static_cast<unsigned long long>(value));
+  *this << '-';
+  // Negating the smallest value overflows, its magnitude does not
+  return writeUnsigned(0 - static_cast<unsigned long long>(value));
+}
+
+FormatBuffer &FormatBuffer::writeUnsigned(unsigned long long value) {
+  char digits[MaxDigits];
+  char *end = digits + sizeof(digits);
+  char *first = writeDigits(end, value);
+  return *this << StringRef(first, static_cast<size_t>(end - first));
+}
+} // namespace Common
@@ -0,0 +1,86 @@
+#include "Common/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Common {
+Logger::Logger(std::ostream &stream, double flushInterval, size_t capacity)
+    : out(stream), interval(std::max(0.001, flushInterval)), head(0), tail(0),
+      stopping(false) {
+  // Positions wrap with a mask
+  size_t size = 1;
+  while (size < capacity)
+    size *= 2;
+  ring.resize(size);
+
+  writer = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+  {
+    std::lock_guard<std::mutex> lock(stopMutex);
+    stopping = true;
+  }
+  stopped.notify_one();
+  writer.join();
+}
+
+void Logger::append(StringRef text) {
+  size_t mask = ring.size() - 1;
+  size_t end = tail.load(std::memory_order_relaxed);
+  const char *data = text.data();
+  size_t left = text.size();
+
+  while (left > 0) {
+    size_t room = ring.size() - (end - head.load(std::memory_order_acquire));
+    if (room == 0) {
+      // Let the writer see what is queued so it can make room
+      tail.store(end, std::memory_order_release);
+      std::this_thread::yield();
+      continue;
+    }
+
+    size_t chunk = std::min(std::min(left, room), ring.size() - (end & mask));
+    std::memcpy(&ring[end & mask], data, chunk);
+    end += chunk;
+    data += chunk;
+    left -= chunk;
+  }
+  tail.store(end, std::memory_order_release);
+}
+
+void Logger::write(StringRef line) {
+  append(line);
+  append("\n");
+}
+
+bool Logger::drain() {
+  size_t mask = ring.size() - 1;
+  size_t start = head.load(std::memory_order_relaxed);
+  size_t end = tail.load(std::memory_order_acquire);
+  if (start == end)
+    return false;
+
+  // What is queued may wrap around the end of the ring
+  size_t first = start & mask;
+  size_t beforeWrap = std::min(end - start, ring.size() - first);
+  out.write(&ring[first], static_cast<std::streamsize>(beforeWrap));
+  out.write(ring.data(), static_cast<std::streamsize>(end - start - beforeWrap));
+  out.flush();
+
+  head.store(end, std::memory_order_release);
+  return true;
+}
+
+void Logger::run() {
+  bool stop = false;
+  while (!stop) {
+    {
+      std::unique_lock<std::mutex> lock(stopMutex);
+      stop = stopped.wait_for(lock, interval, [this] { return stopping; });
+    }
+    // Everything queued before stopping was set is seen by the last drain
+    drain();
+  }
+}
+} // namespace Common
@@ -0,0 +1,102 @@
+#include "Common/Options.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Common/Process.h"
+#include "Common/Timer.h"
+
+namespace Common {
+namespace {
+// Parses the whole of arg as a number, returning false if it is not one
+bool readDouble(const std::string &arg, double &value) {
+  try {
+    size_t used;
+    double parsed = std::stod(arg, &used);
+    if (used != arg.size())
+      return false;
+    value = parsed;
+    return true;
+  } catch (const std::invalid_argument &) {
+  } catch (const std::out_of_range &) {
+  }
+  return false;
+}
+
+void reportInvalid(const char *what, const char *arg) {
+  std::cerr << "Invalid " << what << " of " << arg << std::endl;
+}
+} // namespace
+
+int parseCount(const char *arg, int fallback) {
+  try {
+    size_t used;
+    int parsed = std::stoi(arg, &used);
+    if (arg[used] == '\0')
+      return std::max(1, parsed);
+  } catch (const std::invalid_argument &) {
+  } catch (const std::out_of_range &) {
+  }
+  reportInvalid("count", arg);
+  return fallback;
+}
+
+bool parseDouble(const char *arg, double &value) {
+  if (readDouble(arg, value))
+    return true;
+  std::cerr << "Invalid number " << arg << std::endl;
+  return false;
+}
+
+bool parseModeratorOption(int argc, char **argv, int &i,
+                          ModeratorOptions &options) {
+  std::string arg = argv[i];
+  bool hasValue = i + 1 < argc;
+
+  if (arg == "--enforce") {
+    options.enforceTimeLimit = true;
+    // The limit is optional
+    if (hasValue && readDouble(argv[i + 1], options.turnTimeLimit))
+      ++i;
+  } else if (arg == "--clock" && hasValue) {
+    if (!parseTimeControl(argv[++i], options.clockBase, options.clockIncrement))
+      reportInvalid("time control", argv[i]);
+  } else if (arg == "--announce-time") {
+    options.announceTime = true;
+  } else if (arg == "--adjudicate") {
+    options.adjudicateRaces = true;
+  } else if (arg == "--max-plies" && hasValue) {
+    options.maxPlies = parseCount(argv[++i], options.maxPlies);
+  } else if (arg == "--allow-dupe-states") {
+    options.forbidDuplicateStates = false;
+  } else if (arg == "--async-log" && hasValue) {
+    double interval;
+    if (readDouble(argv[++i], interval))
+      options.logFlushInterval = interval / 1000;
+    else
+      reportInvalid("flush interval", argv[i]);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool parseMatchOption(int argc, char **argv, int &i, MatchSpec &spec) {
+  std::string arg = argv[i];
+  bool hasValue = i + 1 < argc;
+
+  if (arg == "--cpus" && hasValue) {
+    if (!parseCpuList(argv[++i], spec.agents.cpus))
+      reportInvalid("CPU list", argv[i]);
+  } else if (arg == "--memory" && hasValue) {
+    if (!parseMegabytes(argv[++i], spec.memoryLimit))
+      reportInvalid("memory limit", argv[i]);
+  } else if (arg == "--address-space" && hasValue) {
+    if (!parseMegabytes(argv[++i], spec.agents.addressSpaceLimit))
+      reportInvalid("address space limit", argv[i]);
+  } else {
+    return parseModeratorOption(argc, argv, i, spec.options);
+  }
+  return true;
+}
+} // namespace Common
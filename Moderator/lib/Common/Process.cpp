@@ -0,0 +1,328 @@
+//===------------------------------------------------------------*- C++ -*-===//
+#include "Common/Process.h"
+
+#include <cerrno>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Common/String.h"
+
+namespace Common {
+namespace {
+// CPUs an agent can be pinned to, which is all a cpu_set_t holds
+#ifdef CPU_SETSIZE
+const int MaxCpus = CPU_SETSIZE;
+#else
+const int MaxCpus = 1024;
+#endif
+
+void closeFd(int &fd) {
+  if (fd >= 0)
+    close(fd);
+  fd = -1;
+}
+
+// pipe2 is not available everywhere, and nothing here forks concurrently
+bool closeOnExecPipe(int fds[2]) {
+  if (pipe(fds) != 0)
+    return false;
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+  fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+  return true;
+}
+
+#ifdef __linux__
+// Calls visit with the /proc directory of process id and of each of its
+// descendants, found through the children list of each of their threads
+void visitTree(pid_t id, const std::function<void(const std::string &proc)> &visit) {
+  std::string proc = "/proc/" + std::to_string(id);
+  visit(proc);
+
+  DIR *tasks = opendir((proc + "/task").c_str());
+  if (tasks == nullptr)
+    return;
+  while (dirent *task = readdir(tasks)) {
+    if (task->d_name[0] == '.')
+      continue;
+    std::ifstream children((proc + "/task/" + task->d_name + "/children").c_str());
+    pid_t child;
+    while (children >> child)
+      visitTree(child, visit);
+  }
+  closedir(tasks);
+}
+
+// Adds the CPU ticks in a process's stat to ticks. Children it has reaped
+// are counted in its own stat
+void addTicks(const std::string &proc, unsigned long long &ticks) {
+  std::ifstream stat((proc + "/stat").c_str());
+  std::string line;
+  if (!std::getline(stat, line))
+    return;
+
+  // The name in parentheses may hold spaces, the fields after it do not.
+  // utime, stime, cutime and cstime are fields 14 to 17, the name is field 2
+  size_t nameEnd = line.rfind(')');
+  if (nameEnd == std::string::npos)
+    return;
+  std::istringstream fields(line.substr(nameEnd + 1));
+  std::string skip;
+  for (int field = 3; field < 14; ++field)
+    fields >> skip;
+  unsigned long long time;
+  for (int field = 14; field <= 17 && fields >> time; ++field)
+    ticks += time;
+}
+
+// Adds the peak resident set size in a process's status to bytes
+void addPeakMemory(const std::string &proc, long long &bytes) {
+  std::ifstream status((proc + "/status").c_str());
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, 6, "VmHWM:") != 0)
+      continue;
+    std::istringstream fields(line.substr(6));
+    long long kilobytes;
+    if (fields >> kilobytes)
+      bytes += kilobytes * 1024;
+    return;
+  }
+}
+#endif
+} // namespace
+
+Process::Process() : pid(-1), in(-1), out(-1), finalCpuTime(-1.0) {}
+
+Process::~Process() {
+  stop();
+}
+
+bool Process::start(const std::vector<std::string> &args,
+                    const ProcessOptions &options) {
+  stop();
+  finalCpuTime = -1.0;
+  if (args.empty())
+    return false;
+
+  // Built before forking, the child may only make async-signal-safe calls
+  std::vector<char *> argv;
+  for (const auto &arg : args)
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  argv.push_back(nullptr);
+
+  // The status pipe reports a failed exec, it closes unused on success
+  int toChild[2], fromChild[2], status[2];
+  if (!closeOnExecPipe(toChild))
+    return false;
+  if (!closeOnExecPipe(fromChild)) {
+    close(toChild[0]);
+    close(toChild[1]);
+    return false;
+  }
+  if (!closeOnExecPipe(status)) {
+    for (int fd : {toChild[0], toChild[1], fromChild[0], fromChild[1]})
+      close(fd);
+    return false;
+  }
+
+  pid = fork();
+  if (pid == 0) {
+    // Its own group, so stopping it also stops anything it started
+    setpgid(0, 0);
+
+    dup2(toChild[0], STDIN_FILENO);
+    dup2(fromChild[1], STDOUT_FILENO);
+    if (options.discardErrors) {
+      int devNull = open("/dev/null", O_WRONLY);
+      if (devNull >= 0)
+        dup2(devNull, STDERR_FILENO);
+    }
+
+    // Inherited by every process it starts
+    if (options.addressSpaceLimit > 0) {
+      rlimit limit;
+      limit.rlim_cur = static_cast<rlim_t>(options.addressSpaceLimit);
+      limit.rlim_max = static_cast<rlim_t>(options.addressSpaceLimit);
+      setrlimit(RLIMIT_AS, &limit);
+    }
+
+#ifdef __linux__
+    // Inherited by every thread and process it starts
+    if (!options.cpus.empty()) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (int cpu : options.cpus)
+        CPU_SET(static_cast<size_t>(cpu), &set);
+      sched_setaffinity(0, sizeof(set), &set);
+    }
+#endif
+
+    execvp(argv[0], argv.data());
+
+    int error = errno;
+    ssize_t written = write(status[1], &error, sizeof(error));
+    static_cast<void>(written);
+    _exit(127);
+  }
+
+  close(toChild[0]);
+  close(fromChild[1]);
+  close(status[1]);
+  in = toChild[1];
+  out = fromChild[0];
+
+  if (pid < 0) {
+    close(status[0]);
+    stop();
+    return false;
+  }
+
+  // Either the parent or the child may get here first
+  setpgid(pid, pid);
+
+  int error = 0;
+  ssize_t got;
+  do {
+    got = read(status[0], &error, sizeof(error));
+  } while (got < 0 && errno == EINTR);
+  close(status[0]);
+  if (got > 0) {
+    stop();
+    return false;
+  }
+
+  fcntl(in, F_SETFL, fcntl(in, F_GETFL) | O_NONBLOCK);
+  fcntl(out, F_SETFL, fcntl(out, F_GETFL) | O_NONBLOCK);
+  return true;
+}
+
+void Process::stop() {
+  closeFd(in);
+  closeFd(out);
+
+  if (pid > 0) {
+    kill(-pid, SIGKILL);
+    kill(pid, SIGKILL);
+    rusage usage;
+    pid_t reaped;
+    while ((reaped = wait4(pid, nullptr, 0, &usage)) < 0 && errno == EINTR)
+      continue;
+    if (reaped == pid)
+      finalCpuTime = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+                     static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+  }
+  pid = -1;
+}
+
+bool Process::running() const {
+  return pid > 0;
+}
+
+double Process::cpuTime() const {
+  if (pid <= 0)
+    return finalCpuTime;
+
+#ifdef __linux__
+  unsigned long long ticks = 0;
+  visitTree(pid, [&](const std::string &proc) { addTicks(proc, ticks); });
+  return static_cast<double>(ticks) / static_cast<double>(sysconf(_SC_CLK_TCK));
+#else
+  return -1.0;
+#endif
+}
+
+long long Process::peakMemory() const {
+#ifdef __linux__
+  if (pid <= 0)
+    return -1;
+
+  long long bytes = 0;
+  visitTree(pid, [&](const std::string &proc) { addPeakMemory(proc, bytes); });
+  return bytes;
+#else
+  return -1;
+#endif
+}
+
+pid_t Process::id() const {
+  return pid;
+}
+
+int Process::input() const {
+  return in;
+}
+
+int Process::output() const {
+  return out;
+}
+
+std::vector<std::string> splitCommand(const std::string &command) {
+  std::vector<std::string> args;
+  for (const auto &arg : Common::split(command)) {
+    if (!arg.empty())
+      args.push_back(arg);
+  }
+  return args;
+}
+
+bool parseCpuList(const std::string &list, std::vector<int> &cpus) {
+  std::vector<int> parsed;
+  for (const auto &range : Common::split(list, ',')) {
+    size_t dash = range.find('-');
+    try {
+      size_t used;
+      int first = std::stoi(range.substr(0, dash), &used);
+      if (used != range.substr(0, dash).size())
+        return false;
+      int last = first;
+      if (dash != std::string::npos) {
+        std::string end = range.substr(dash + 1);
+        last = std::stoi(end, &used);
+        if (used != end.size())
+          return false;
+      }
+      if (first < 0 || last < first || last >= MaxCpus)
+        return false;
+      for (int cpu = first; cpu <= last; ++cpu)
+        parsed.push_back(cpu);
+    } catch (const std::invalid_argument &) {
+      return false;
+    } catch (const std::out_of_range &) {
+      return false;
+    }
+  }
+
+  if (parsed.empty())
+    return false;
+  cpus = parsed;
+  return true;
+}
+
+bool parseMegabytes(const std::string &megabytes, size_t &bytes) {
+  try {
+    size_t used;
+    unsigned long long parsed = std::stoull(megabytes, &used);
+    if (used != megabytes.size() || megabytes[0] == '-' || parsed == 0 ||
+        parsed > std::numeric_limits<size_t>::max() / (1024 * 1024))
+      return false;
+    bytes = static_cast<size_t>(parsed) * 1024 * 1024;
+    return true;
+  } catch (const std::invalid_argument &) {
+  } catch (const std::out_of_range &) {
+  }
+  return false;
+}
+} // namespace Common
@@ -0,0 +1,188 @@
+#include "Common/Profile.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "Common/Format.h"
+
+namespace Common {
+namespace {
+const unsigned Zones = static_cast<unsigned>(Zone::Count);
+// Buckets to each power of two. Times below SubBuckets nanoseconds get a
+// bucket each
+const unsigned SubBuckets = 4;
+const unsigned Buckets = 64 * SubBuckets;
+
+const char *const ZoneNames[Zones] = {"read",  "parse",     "validate",
+                                      "apply", "broadcast", "movegen",
+                                      "search"};
+
+// Only the thread that owns the counts writes them, the summary may read
+// them from another thread at any time
+struct ZoneCounts {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> total;
+  std::atomic<uint64_t> max;
+  std::array<std::atomic<uint64_t>, Buckets> buckets;
+};
+
+struct ThreadCounts {
+  std::array<ZoneCounts, Zones> zones;
+};
+
+unsigned bucketOf(uint64_t nanoseconds) {
+  if (nanoseconds < SubBuckets)
+    return static_cast<unsigned>(nanoseconds);
+  unsigned top = 63;
+  while ((nanoseconds >> top) == 0)
+    --top;
+  unsigned sub =
+      static_cast<unsigned>(nanoseconds >> (top - 2)) & (SubBuckets - 1);
+  return SubBuckets * (top - 1) + sub;
+}
+
+// The largest time that falls in bucket
+uint64_t bucketTop(unsigned bucket) {
+  if (bucket < SubBuckets)
+    return bucket;
+  unsigned top = bucket / SubBuckets + 1;
+  uint64_t sub = bucket % SubBuckets;
+  return ((SubBuckets + sub + 1) << (top - 2)) - 1;
+}
+
+void add(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value,
+                std::memory_order_relaxed);
+}
+
+class Registry {
+public:
+  Registry() : reported(false) {}
+  // Threads may still be counting at exit, so their counts are never freed
+  ~Registry() {
+#ifdef COMMON_PROFILE
+    if (!reported)
+      writeProfile(std::cerr);
+#endif
+  }
+
+  // Don't allow copies for simplicity (the functions below are for the rule of 5)
+  // copy ctor
+  Registry(const Registry &) = delete;
+  // move ctor
+  Registry(const Registry &&) = delete;
+  // copy assignment
+  Registry &operator=(const Registry &) = delete;
+  // move assignment
+  Registry &operator=(const Registry &&) = delete;
+
+  ThreadCounts *add() {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.push_back(new ThreadCounts());
+    return threads.back();
+  }
+
+  std::vector<ThreadCounts *> all() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return threads;
+  }
+
+  std::atomic<bool> reported;
+
+private:
+  std::mutex mutex;
+  std::vector<ThreadCounts *> threads;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+thread_local ThreadCounts *threadCounts = nullptr;
+} // namespace
+
+const char *zoneName(Zone zone) {
+  return ZoneNames[static_cast<unsigned>(zone)];
+}
+
+void recordZone(Zone zone, uint64_t nanoseconds) {
+  // Registered the first time the thread counts anything
+  if (threadCounts == nullptr)
+    threadCounts = registry().add();
+
+  ZoneCounts &counts = threadCounts->zones[static_cast<unsigned>(zone)];
+  add(counts.count, 1);
+  add(counts.total, nanoseconds);
+  if (nanoseconds > counts.max.load(std::memory_order_relaxed))
+    counts.max.store(nanoseconds, std::memory_order_relaxed);
+  add(counts.buckets[bucketOf(nanoseconds)], 1);
+}
+
+ZoneSummary summarizeZone(Zone zone) {
+  ZoneSummary summary{0, 0, 0, 0, 0, 0};
+  std::array<uint64_t, Buckets> buckets{};
+  for (ThreadCounts *thread : registry().all()) {
+    const ZoneCounts &counts = thread->zones[static_cast<unsigned>(zone)];
+    summary.count += counts.count.load(std::memory_order_relaxed);
+    summary.total += counts.total.load(std::memory_order_relaxed);
+    summary.max =
+        std::max(summary.max, counts.max.load(std::memory_order_relaxed));
+    for (unsigned i = 0; i < Buckets; ++i)
+      buckets[i] += counts.buckets[i].load(std::memory_order_relaxed);
+  }
+
+  // The smallest time at least this share of the times are no more than
+  struct Percentile {
+    uint64_t ZoneSummary::*field;
+    uint64_t share;
+  };
+  const Percentile percentiles[] = {{&ZoneSummary::p50, 50},
+                                    {&ZoneSummary::p90, 90},
+                                    {&ZoneSummary::p99, 99}};
+  for (const Percentile &p : percentiles) {
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < Buckets; ++i) {
+      seen += buckets[i];
+      if (seen > 0 && 100 * seen >= p.share * summary.count) {
+        summary.*p.field = std::min(bucketTop(i), summary.max);
+        break;
+      }
+    }
+  }
+  return summary;
+}
+
+void writeProfile(std::ostream &out) {
+  for (unsigned i = 0; i < Zones; ++i) {
+    ZoneSummary summary = summarizeZone(static_cast<Zone>(i));
+    if (summary.count == 0)
+      continue;
+
+    char buffer[256];
+    FormatBuffer line(buffer);
+    line << "PROFILE | " << ZoneNames[i] << " | Count: " << summary.count
+         << " | Total: ";
+    line.fixed(static_cast<double>(summary.total) / 1e6, 3) << "ms | Mean: ";
+    line.fixed(static_cast<double>(summary.total) / 1e3 /
+                   static_cast<double>(summary.count), 1)
+        << "us | p50: ";
+    line.fixed(static_cast<double>(summary.p50) / 1e3, 1) << "us | p90: ";
+    line.fixed(static_cast<double>(summary.p90) / 1e3, 1) << "us | p99: ";
+    line.fixed(static_cast<double>(summary.p99) / 1e3, 1) << "us | Max: ";
+    line.fixed(static_cast<double>(summary.max) / 1e3, 1) << "us\n";
+    // Whole lines, as the agents may share the stream
+    out.write(line.str().data(), static_cast<std::streamsize>(line.size()));
+    out.flush();
+  }
+}
+
+void reportProfile() {
+  registry().reported = true;
+  writeProfile(std::cerr);
+}
+} // namespace Common
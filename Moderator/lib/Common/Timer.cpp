@@ -2,10 +2,12 @@
 #include "Common/Timer.h"
 
 #include <cassert>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+#include <string>
 #include <iostream>
 using std::ostream;
-#include <iomanip>
-using std::setw;
 #include <chrono>
 using std::chrono::duration_cast;
 using std::chrono::hours;
@@ -15,18 +17,24 @@ using std::chrono::milliseconds;
 
 namespace Common {
 std::ostream &operator<<(std::ostream &os, Timer &t) {
-  if (t.elapsed_valid != t.Valid) {
-    os << "Time information not valid";
-    return os;
-  }
+  char buffer[64];
+  FormatBuffer out(buffer);
+  out << t;
+  return os << out.str();
+}
+
+FormatBuffer &operator<<(FormatBuffer &out, Timer &t) {
+  if (t.elapsed_valid != t.Valid)
+    return out << "Time information not valid";
   hours hh = duration_cast<hours>(t.elapsed);
   minutes mm = duration_cast<minutes>(t.elapsed - hh);
   seconds ss = duration_cast<seconds>(t.elapsed - hh - mm);
   milliseconds ms = duration_cast<milliseconds>(t.elapsed - hh - mm - ss);
 
-  os << setw(2) << hh.count() << "h " << setw(2) << mm.count() << "m "
-     << setw(2) << ss.count() << "s " << setw(3) << ms.count() << "ms";
-  return os;
+  out.padded(hh.count(), 2) << "h ";
+  out.padded(mm.count(), 2) << "m ";
+  out.padded(ss.count(), 2) << "s ";
+  return out.padded(ms.count(), 3) << "ms";
 }
 
 Timer::Timer() : elapsed_valid(Uninitialized) {}
@@ -49,4 +57,38 @@ void Timer::stop() {
   if (elapsed_valid == Invalid)
     elapsed_valid = Valid;
 }
+
+bool parseTimeControl(const std::string &control, double &base,
+                      double &increment) {
+  size_t plus = control.find('+');
+  std::string baseText = control.substr(0, plus);
+  std::string incrementText =
+      plus == std::string::npos ? "0" : control.substr(plus + 1);
+
+  try {
+    size_t used;
+    double parsedBase = std::stod(baseText, &used);
+    if (used != baseText.size())
+      return false;
+    double parsedIncrement = std::stod(incrementText, &used);
+    if (used != incrementText.size() || !(parsedBase > 0.0) ||
+        !(parsedIncrement >= 0.0))
+      return false;
+
+    base = parsedBase;
+    increment = parsedIncrement;
+    return true;
+  } catch (const std::invalid_argument &) {
+  } catch (const std::out_of_range &) {
+  }
+  return false;
+}
+
+int pollTimeout(double seconds) {
+  if (std::isinf(seconds) || seconds * 1000 >= INT_MAX)
+    return -1;
+  if (seconds <= 0.0)
+    return 0;
+  return static_cast<int>(std::ceil(seconds * 1000));
+}
 } // namespace Common
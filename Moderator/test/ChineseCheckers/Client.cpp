@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "ChineseCheckers/Client.h"
+#include "ChineseCheckers/State.h"
+
+TEST(Client, MoveFrame) {
+  typedef ChineseCheckers::Client Client;
+
+  // Cell 10 is a newline, which a frame may hold
+  std::string frame = Client::moveFrame({10, 19});
+  ASSERT_EQ(Client::frameSize(frame[0]), frame.size());
+  ChineseCheckers::Move m{0, 0};
+  EXPECT_TRUE(Client::readMoveFrame(frame, m));
+  EXPECT_EQ(10u, m.from);
+  EXPECT_EQ(19u, m.to);
+
+  EXPECT_FALSE(Client::readMoveFrame(frame.substr(0, 2), m));
+  EXPECT_FALSE(Client::readMoveFrame("MOV", m));
+  EXPECT_EQ(0u, Client::frameSize('M'));
+}
+
+TEST(Client, MessageBuffer) {
+  typedef ChineseCheckers::Client Client;
+
+  char buffer[64];
+  Common::FormatBuffer out(buffer);
+  EXPECT_EQ("MOVE FROM 27 TO 36", Client::moveMessage({27, 36}, out));
+  // Messages are appended to what the buffer holds
+  EXPECT_EQ("BEGIN CHINESECHECKERS A B", Client::startGameMessage("A", "B", out));
+  EXPECT_EQ("MOVE FROM 27 TO 36BEGIN CHINESECHECKERS A B", out.str());
+  EXPECT_EQ(Client::moveMessage({0, 80}), "MOVE FROM 0 TO 80");
+}
+
+TEST(Client, MessageFrame) {
+  typedef ChineseCheckers::Client Client;
+
+  std::string frame;
+  EXPECT_TRUE(Client::messageFrame("MOVE FROM 27 TO 36", frame));
+  EXPECT_EQ(Client::moveFrame({27, 36}), frame);
+  EXPECT_FALSE(Client::messageFrame("MOVE FROM 27 TO 81", frame));
+  EXPECT_FALSE(Client::messageFrame("BEGIN CHINESECHECKERS A B", frame));
+  EXPECT_FALSE(Client::messageFrame("#quit", frame));
+
+  ChineseCheckers::State s, loaded;
+  s.applyMove({27, 36});
+  EXPECT_TRUE(Client::messageFrame(Client::loadStateMessage(s.dumpState()), frame));
+  ASSERT_EQ(Client::frameSize(frame[0]), frame.size());
+  EXPECT_EQ(Client::stateFrame(s), frame);
+  EXPECT_TRUE(Client::readStateFrame(frame, loaded));
+  EXPECT_EQ(s.dumpState(), loaded.dumpState());
+  EXPECT_FALSE(Client::messageFrame("LOADSTATE 3 0", frame));
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/GameLog.h"
+
+TEST(GameLog, Parse) {
+  const char *log = "BEGIN CHINESECHECKERS Random1 Random2\n"
+                    "# MOVE | Turn: 1 | Player 1: Random1 | Move: 1 MOVE FROM "
+                    "27 TO 36 | Elapsed:  0h  0m  0s   1ms\n"
+                    "MOVE FROM 27 TO 36\n"
+                    "MOVE FROM 53 TO 44\r\n"
+                    "MOVE FROM 3 TO\n"
+                    "# Invalid move: 1 MOVE FROM 0 TO 80\n"
+                    "FINAL Random2 BEATS Random1\n"
+                    "# 2 moves were played in total\n"
+                    "#quit\n"
+                    "BEGIN CHINESECHECKERS A B\n"
+                    "MOVE FROM 2 TO 4";
+
+  std::vector<ChineseCheckers::LoggedGame> games;
+  ChineseCheckers::parseGameLog(log, log + std::strlen(log), games);
+
+  ASSERT_EQ(2u, games.size());
+
+  const auto &first = games[0];
+  EXPECT_EQ(1u, first.line);
+  EXPECT_EQ("Random1", first.player1);
+  EXPECT_EQ("Random2", first.player2);
+  ASSERT_EQ(3u, first.moves.size());
+  EXPECT_EQ((ChineseCheckers::Move{27, 36}), first.moves[0].move);
+  EXPECT_EQ(3u, first.moves[0].line);
+  EXPECT_EQ((ChineseCheckers::Move{53, 44}), first.moves[1].move);
+  // Malformed moves become the null move
+  EXPECT_TRUE(first.moves[2].move.isNull());
+  EXPECT_EQ(ChineseCheckers::Forfeit::InvalidMove, first.forfeit);
+  EXPECT_TRUE(first.hasFinal);
+  EXPECT_EQ(7u, first.finalLine);
+  EXPECT_EQ("Random2", first.winner);
+  EXPECT_EQ("Random1", first.loser);
+
+  const auto &second = games[1];
+  EXPECT_EQ(10u, second.line);
+  EXPECT_EQ("A", second.player1);
+  EXPECT_EQ("B", second.player2);
+  ASSERT_EQ(1u, second.moves.size());
+  EXPECT_EQ((ChineseCheckers::Move{2, 4}), second.moves[0].move);
+  EXPECT_EQ(ChineseCheckers::Forfeit::None, second.forfeit);
+  EXPECT_FALSE(second.hasFinal);
+}
+
+TEST(GameLog, Adjudicated) {
+  const char *log = "BEGIN CHINESECHECKERS A B\n"
+                    "MOVE FROM 27 TO 36\n"
+                    "MOVE FROM 53 TO 44\n"
+                    "# Adjudicated: Ply limit of 2. Race counts are 77 and 77. "
+                    "1:A wins.\n"
+                    "FINAL A BEATS B\n";
+
+  std::vector<ChineseCheckers::LoggedGame> games;
+  ChineseCheckers::parseGameLog(log, log + std::strlen(log), games);
+
+  ASSERT_EQ(1u, games.size());
+  EXPECT_EQ(ChineseCheckers::Forfeit::PlyLimit, games[0].forfeit);
+  EXPECT_EQ("A", games[0].winner);
+}
+
+TEST(GameLog, StartState) {
+  const char *log = "BEGIN CHINESECHECKERS A B\n"
+                    "FINAL A BEATS B\n"
+                    "LOADSTATE 2 0 1\n"
+                    "BEGIN CHINESECHECKERS B A\n";
+
+  std::vector<ChineseCheckers::LoggedGame> games;
+  ChineseCheckers::parseGameLog(log, log + std::strlen(log), games);
+
+  ASSERT_EQ(2u, games.size());
+  EXPECT_TRUE(games[0].startState.empty());
+  EXPECT_EQ("2 0 1", games[1].startState);
+}
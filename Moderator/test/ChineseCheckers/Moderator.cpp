@@ -0,0 +1,437 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChineseCheckers/Client.h"
+#include "ChineseCheckers/State.h"
+#include "Common/Match.h"
+#include "Common/Moderator.h"
+#ifdef __linux__
+#include "Common/Server.h"
+#endif
+
+typedef Common::Moderator<ChineseCheckers::State, ChineseCheckers::Client>
+    Moderator;
+
+Common::ModeratorOptions hostedOptions();
+
+Common::ModeratorOptions hostedOptions() {
+  Common::ModeratorOptions options;
+  options.printBoard = false;
+  options.quiet = true;
+  options.diagnostics = nullptr;
+  return options;
+}
+
+TEST(Moderator, Hosted) {
+  std::vector<std::string> sent;
+  Moderator m;
+  ASSERT_TRUE(m.begin(hostedOptions(), "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+  ASSERT_EQ(1u, sent.size());
+  EXPECT_EQ("BEGIN CHINESECHECKERS A B", sent[0]);
+
+  m.handleMessage(0, "MOVE FROM 27 TO 36");
+  m.handleMessage(1, "MOVE FROM 53 TO 44");
+  ASSERT_EQ(3u, sent.size());
+  EXPECT_EQ("MOVE FROM 27 TO 36", sent[1]);
+  EXPECT_EQ("MOVE FROM 53 TO 44", sent[2]);
+  EXPECT_FALSE(m.finished());
+  EXPECT_EQ(-1, m.winner());
+
+  // Player 1 tries to take player 2's piece
+  m.handleMessage(0, "MOVE FROM 36 TO 44");
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(1, m.winner());
+  EXPECT_EQ(3, m.moves());
+  ASSERT_EQ(5u, sent.size());
+  EXPECT_EQ("FINAL B BEATS A", sent[3]);
+  EXPECT_EQ("#quit", sent[4]);
+
+  // Nothing is heard once the game is over
+  m.handleMessage(1, "MOVE FROM 44 TO 45");
+  EXPECT_EQ(5u, sent.size());
+}
+
+TEST(Moderator, OutOfTurn) {
+  std::vector<std::string> sent;
+  Moderator m;
+  ASSERT_TRUE(m.begin(hostedOptions(), "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+
+  m.handleMessage(1, "MOVE FROM 53 TO 44");
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(0, m.winner());
+  EXPECT_EQ("FINAL A BEATS B", sent[1]);
+}
+
+TEST(Moderator, PlayMove) {
+  std::vector<std::string> sent;
+  Moderator m;
+  ASSERT_TRUE(m.begin(hostedOptions(), "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+
+  // Decoded moves are broadcast as messages like any other
+  m.playMove(0, {27, 36});
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ("MOVE FROM 27 TO 36", sent[1]);
+  EXPECT_EQ(1, m.moves());
+
+  m.playMove(0, {36, 45});
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(1, m.winner());
+  EXPECT_EQ("FINAL B BEATS A", sent[2]);
+}
+
+TEST(Moderator, AsyncLog) {
+  std::stringstream diagnostics;
+  Common::ModeratorOptions options = hostedOptions();
+  options.diagnostics = &diagnostics;
+  options.logFlushInterval = 10.0;
+  {
+    Moderator m;
+    ASSERT_TRUE(m.begin(options, "A", "B", [](const std::string &) {}));
+    m.handleMessage(0, "MOVE FROM 27 TO 36");
+    m.forfeit(1, "Exited");
+  }
+
+  // Everything is written by the time the moderator is gone
+  std::string written = diagnostics.str();
+  EXPECT_NE(std::string::npos, written.find("MOVE | Turn: 1 | Player 1: A"));
+  EXPECT_NE(std::string::npos, written.find("Forfeit: Exited. 2:B forfeits.\n"));
+}
+
+TEST(Moderator, GUIDeltas) {
+  std::stringstream diagnostics;
+  Common::ModeratorOptions options = hostedOptions();
+  options.printBoard = true;
+  options.guiDeltas = true;
+  options.diagnostics = &diagnostics;
+  Moderator m;
+  ASSERT_TRUE(m.begin(options, "A", "B", [](const std::string &) {}));
+  m.handleMessage(0, "MOVE FROM 27 TO 36");
+
+  std::vector<std::string> boards;
+  for (std::string line; std::getline(diagnostics, line);)
+    if (line.compare(0, 4, "MOVE") != 0)
+      boards.push_back(line.substr(0, line.rfind(" | ") + 3));
+  ChineseCheckers::State start;
+  ASSERT_EQ(2u, boards.size());
+  EXPECT_EQ("GUI | " + start.dumpState() + " | ", boards[0]);
+  // Token 0 is the player to move and cell i is token i + 1
+  EXPECT_EQ("DELTA | 0=2 28=0 37=1 | ", boards[1]);
+}
+
+TEST(Moderator, Forfeit) {
+  std::vector<std::string> sent;
+  Moderator m;
+  ASSERT_TRUE(m.begin(hostedOptions(), "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+
+  m.handleMessage(0, "MOVE FROM 27 TO 36");
+  m.forfeit(0, "Exited");
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(1, m.winner());
+  EXPECT_EQ("FINAL B BEATS A", sent[2]);
+}
+
+TEST(Moderator, DuplicateNames) {
+  std::vector<std::string> sent;
+  Moderator m;
+  EXPECT_FALSE(m.begin(hostedOptions(), "A", "A",
+                       [&](const std::string &msg) { sent.push_back(msg); }));
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(-1, m.winner());
+  EXPECT_TRUE(sent.empty());
+}
+
+TEST(Moderator, Deadline) {
+  std::vector<std::string> sent;
+  Moderator m;
+  Common::ModeratorOptions options = hostedOptions();
+  ASSERT_TRUE(m.begin(options, "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+  EXPECT_TRUE(std::isinf(m.timeLeft()));
+  EXPECT_FALSE(m.enforceDeadline());
+
+  options.enforceTimeLimit = true;
+  options.turnTimeLimit = 0.05;
+  ASSERT_TRUE(m.begin(options, "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+  m.handleMessage(0, "MOVE FROM 27 TO 36");
+  EXPECT_GT(m.timeLeft(), 0.0);
+  EXPECT_FALSE(m.enforceDeadline());
+
+  // B never answers
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  EXPECT_LE(m.timeLeft(), 0.0);
+  EXPECT_TRUE(m.enforceDeadline());
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(0, m.winner());
+  EXPECT_EQ("FINAL A BEATS B", sent[sent.size() - 2]);
+  EXPECT_TRUE(std::isinf(m.timeLeft()));
+}
+
+TEST(Moderator, Clock) {
+  std::vector<std::string> sent;
+  Moderator m;
+  Common::ModeratorOptions options = hostedOptions();
+  options.clockBase = 0.2;
+  options.clockIncrement = 10;
+  options.announceTime = true;
+  ASSERT_TRUE(m.begin(options, "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ("TIME 200 200", sent[1]);
+  EXPECT_LE(m.timeLeft(), 0.2);
+
+  // A earns the increment
+  m.handleMessage(0, "MOVE FROM 27 TO 36");
+  ASSERT_EQ(4u, sent.size());
+  EXPECT_EQ("MOVE FROM 27 TO 36", sent[2]);
+  std::vector<std::string> tokens = Common::split(sent[3]);
+  ASSERT_EQ(3u, tokens.size());
+  EXPECT_EQ("TIME", tokens[0]);
+  EXPECT_GT(std::stoi(tokens[1]), 10000);
+  EXPECT_EQ("200", tokens[2]);
+
+  // B's clock runs out
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  EXPECT_TRUE(m.enforceDeadline());
+  EXPECT_EQ(0, m.winner());
+}
+
+TEST(Moderator, PlyLimit) {
+  std::vector<std::string> sent;
+  Moderator m;
+  Common::ModeratorOptions options = hostedOptions();
+  options.maxPlies = 2;
+  ASSERT_TRUE(m.begin(options, "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+
+  m.handleMessage(0, "MOVE FROM 27 TO 36");
+  EXPECT_FALSE(m.finished());
+
+  // The race is even, so the player to move is ahead
+  m.handleMessage(1, "MOVE FROM 53 TO 44");
+  EXPECT_TRUE(m.finished());
+  EXPECT_EQ(0, m.winner());
+  ASSERT_EQ(5u, sent.size());
+  EXPECT_EQ("FINAL A BEATS B", sent[3]);
+  EXPECT_EQ("#quit", sent[4]);
+}
+
+TEST(Moderator, StartState) {
+  // Player 1 has already moved 27 to 36
+  const std::string start =
+      "2 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 0 0 0 0 0 "
+      "0 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 0 2 2 0 0 "
+      "0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 2";
+
+  std::vector<std::string> sent;
+  Moderator m;
+  Common::ModeratorOptions options = hostedOptions();
+  options.startState = start;
+  ASSERT_TRUE(m.begin(options, "A", "B",
+                      [&](const std::string &msg) { sent.push_back(msg); }));
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ("LOADSTATE " + start, sent[0]);
+  EXPECT_EQ("BEGIN CHINESECHECKERS A B", sent[1]);
+  EXPECT_EQ(1u, m.playerToMove());
+
+  m.handleMessage(1, "MOVE FROM 53 TO 44");
+  ASSERT_EQ(3u, sent.size());
+  EXPECT_EQ("MOVE FROM 53 TO 44", sent[2]);
+  EXPECT_FALSE(m.finished());
+  EXPECT_EQ(0u, m.playerToMove());
+
+  Moderator invalid;
+  options.startState = "1 2 3";
+  EXPECT_FALSE(invalid.begin(options, "A", "B", nullptr));
+  EXPECT_TRUE(invalid.finished());
+}
+
+TEST(Moderator, OpeningSuite) {
+  const std::string path = "Moderator.test.suite";
+  {
+    std::ofstream suite(path.c_str());
+    suite << "# Openings\n"
+             "\n"
+             "LOADSTATE 1 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 "
+             "1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 "
+             "0 2 2 0 0 0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 2\n"
+             "  2 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 0 0 0 0 "
+             "0 0 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 0 2 "
+             "2 0 0 0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 2  \n";
+  }
+
+  std::vector<std::string> states;
+  size_t badLine;
+  EXPECT_TRUE(Common::readOpeningSuite<ChineseCheckers::State>(path, states, badLine));
+  ASSERT_EQ(2u, states.size());
+  EXPECT_EQ(ChineseCheckers::State().dumpState(), states[0]);
+  EXPECT_EQ('2', states[1][0]);
+
+  {
+    std::ofstream suite(path.c_str(), std::ios::app);
+    suite << "1 0 0 0\n";
+  }
+  states.clear();
+  EXPECT_FALSE(Common::readOpeningSuite<ChineseCheckers::State>(path, states, badLine));
+  EXPECT_EQ(5u, badLine);
+
+  std::remove(path.c_str());
+  EXPECT_FALSE(Common::readOpeningSuite<ChineseCheckers::State>(path, states, badLine));
+  EXPECT_EQ(0u, badLine);
+}
+
+std::string relay(const std::string &input);
+
+// Runs the moderator on input as if relayed by a GameMaster, returning what
+// it writes to standard output and error
+std::string relay(const std::string &input) {
+  const std::string path = "Moderator.test.relay";
+  {
+    std::ofstream script(path.c_str());
+    script << input;
+  }
+
+  std::string command = MODERATOR " --quiet < " + path + " 2>&1";
+  std::string output;
+  if (FILE *moderator = popen(command.c_str(), "r")) {
+    char buffer[256];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), moderator)) > 0)
+      output.append(buffer, read);
+    pclose(moderator);
+  }
+  std::remove(path.c_str());
+  return output;
+}
+
+TEST(Moderator, RelayJoined) {
+  // Told of each client as it joins, with an answer to an early poll and a
+  // repeated notice arriving once the game has begun
+  std::string output = relay("#joined 0 moderator\n"
+                             "#joined 1 A\n"
+                             "#joined 2 B\n"
+                             "#players 3\n"
+                             "#joined 2 B\n");
+  EXPECT_NE(std::string::npos, output.find("\nBEGIN CHINESECHECKERS A B\n"))
+      << output;
+  EXPECT_EQ(std::string::npos, output.find("not prefixed")) << output;
+}
+
+TEST(Moderator, RelayPlayers) {
+  // A GameMaster without #notify is polled, and answers one poll late
+  std::string output = relay("#players 2\n"
+                             "#players 3\n"
+                             "#players 3\n"
+                             "#getname 0 moderator\n"
+                             "#getname 1 A\n"
+                             "#getname 2 B\n");
+  EXPECT_NE(std::string::npos, output.find("\nBEGIN CHINESECHECKERS A B\n"))
+      << output;
+  EXPECT_EQ(std::string::npos, output.find("getname 1 name")) << output;
+  EXPECT_EQ(std::string::npos, output.find("not prefixed")) << output;
+}
+
+TEST(Match, HungAgent) {
+  Common::MatchSpec spec;
+  spec.commands = {{"sleep 10", "sleep 10"}};
+  spec.options = hostedOptions();
+  spec.options.enforceTimeLimit = true;
+  spec.options.turnTimeLimit = 0.1;
+
+  // Neither agent ever names itself, the match gives up at the time limit
+  Common::Match<ChineseCheckers::State, ChineseCheckers::Client> match;
+  ASSERT_TRUE(match.start(spec));
+  auto begun = std::chrono::steady_clock::now();
+  match.play();
+  std::chrono::duration<double> took = std::chrono::steady_clock::now() - begun;
+
+  EXPECT_TRUE(match.finished());
+  EXPECT_LT(took.count(), 5.0);
+  EXPECT_EQ(-1, match.result().winner);
+  EXPECT_EQ("sleep 10 did not name itself within the time limit",
+            match.result().error);
+}
+
+TEST(Match, HungAgentOnClock) {
+  Common::MatchSpec spec;
+  spec.commands = {{"sleep 10", "sleep 10"}};
+  spec.options = hostedOptions();
+  spec.options.clockBase = 0.1;
+
+  // Without a move time limit the clock bounds the wait for names
+  Common::Match<ChineseCheckers::State, ChineseCheckers::Client> match;
+  ASSERT_TRUE(match.start(spec));
+  auto begun = std::chrono::steady_clock::now();
+  match.play();
+  std::chrono::duration<double> took = std::chrono::steady_clock::now() - begun;
+
+  EXPECT_TRUE(match.finished());
+  EXPECT_LT(took.count(), 5.0);
+  EXPECT_EQ("sleep 10 did not name itself within the time limit",
+            match.result().error);
+}
+
+#ifdef __linux__
+typedef Common::Server<ChineseCheckers::State, ChineseCheckers::Client> Server;
+
+Common::MatchSpec randomGame();
+
+Common::MatchSpec randomGame() {
+  Common::MatchSpec spec;
+  spec.commands = {{RANDOM_AGENT " A", RANDOM_AGENT " B"}};
+  spec.options = hostedOptions();
+  spec.options.maxPlies = 40;
+  spec.agents.discardErrors = true;
+  return spec;
+}
+
+TEST(Server, Usage) {
+  Server server(1);
+  server.add(randomGame());
+
+  // Both agents have been reaped by the time the game is reported, so its
+  // CPU time is their whole usage and its peak memory has the last sample
+  std::vector<Common::MatchResult> results;
+  ASSERT_TRUE(server.run([&](size_t, const Common::MatchResult &result) {
+    results.push_back(result);
+  }));
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ("", results[0].error);
+  for (unsigned player = 0; player < 2; ++player) {
+    EXPECT_GT(results[0].gameCpuTime[player], 0.0);
+    EXPECT_GT(results[0].peakMemory[player], 0);
+  }
+}
+
+TEST(Server, Queue) {
+  // More games than slots, so most wait for a running one to finish
+  Server server(2);
+  const size_t games = 7;
+  for (size_t game = 0; game < games; ++game)
+    EXPECT_EQ(game, server.add(randomGame()));
+
+  std::vector<int> reported(games, 0);
+  ASSERT_TRUE(server.run([&](size_t game, const Common::MatchResult &result) {
+    ASSERT_LT(game, games);
+    ++reported[game];
+    EXPECT_EQ("", result.error);
+    EXPECT_NE(-1, result.winner);
+    EXPECT_EQ("A", result.names[0]);
+    EXPECT_EQ("B", result.names[1]);
+  }));
+  for (size_t game = 0; game < games; ++game)
+    EXPECT_EQ(1, reported[game]) << "game " << game;
+}
+#endif
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/OpeningBook.h"
+#include "ChineseCheckers/PositionDB.h"
+#include "ChineseCheckers/State.h"
+
+TEST(OpeningBook, Symmetry) {
+  ChineseCheckers::State s;
+  auto start = ChineseCheckers::positionKey(s);
+  auto rotate = ChineseCheckers::Symmetry::Rotate;
+
+  // Seen from the other side the start is the start with player 2 to move
+  EXPECT_TRUE(s.loadState("2 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 "
+                          "0 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 "
+                          "0 0 2 0 0 0 0 0 0 0 2 2 0 0 0 0 0 0 2 2 2 0 0 0 0 0 "
+                          "2 2 2 2"));
+  EXPECT_EQ(ChineseCheckers::positionKey(s),
+            ChineseCheckers::transformKey(start, rotate));
+  EXPECT_EQ(start, ChineseCheckers::transformKey(
+                       ChineseCheckers::transformKey(start, rotate), rotate));
+
+  // Player 2 answering 53 -> 44 mirrors player 1 opening 27 -> 36
+  ChineseCheckers::Move m{27, 36};
+  EXPECT_EQ((ChineseCheckers::Move{53, 44}),
+            ChineseCheckers::transformMove(m, rotate));
+  EXPECT_EQ(ChineseCheckers::transformKey(ChineseCheckers::childKey(start, m), rotate),
+            ChineseCheckers::childKey(ChineseCheckers::transformKey(start, rotate),
+                                      ChineseCheckers::transformMove(m, rotate)));
+
+  // Keys fold the same way as states
+  s.reset();
+  s.applyMove(m);
+  ChineseCheckers::Symmetry keySymmetry, stateSymmetry;
+  auto canonical = ChineseCheckers::canonicalKey(ChineseCheckers::positionKey(s),
+                                                 keySymmetry);
+  auto hash = s.getCanonicalHash(stateSymmetry);
+  EXPECT_EQ(stateSymmetry, keySymmetry);
+  for (size_t i = 0; i < canonical.size(); ++i)
+    EXPECT_EQ(hash[i], canonical[i]);
+}
+
+TEST(OpeningBook, Probe) {
+  const std::string dbPath = "OpeningBook.test.db";
+  const std::string bookPath = "OpeningBook.test.book";
+
+  ChineseCheckers::LoggedGame game;
+  game.line = 1;
+  game.player1 = "A";
+  game.player2 = "B";
+  game.moves = {{{27, 36}, 0}, {{53, 44}, 0}, {{18, 20}, 0}};
+  game.forfeit = ChineseCheckers::Forfeit::None;
+  game.hasFinal = true;
+  game.finalLine = 0;
+  game.winner = "A";
+  game.loser = "B";
+
+  ChineseCheckers::PositionDB empty;
+  ChineseCheckers::PositionDBBuilder builder;
+  EXPECT_TRUE(builder.addGame(game));
+  ASSERT_TRUE(builder.write(dbPath, empty));
+
+  ChineseCheckers::PositionDB db;
+  ASSERT_TRUE(db.open(dbPath));
+  EXPECT_EQ(4u, db.size());
+
+  // The last position has no continuation
+  EXPECT_EQ(3, ChineseCheckers::OpeningBook::build(bookPath, db, 1));
+
+  ChineseCheckers::OpeningBook book;
+  book.open(bookPath);
+
+  ChineseCheckers::State s;
+  ChineseCheckers::Move m;
+  EXPECT_TRUE(book.probe(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{27, 36}), m);
+  EXPECT_EQ(3u, book.size());
+
+  s.applyMove(m);
+  EXPECT_TRUE(book.probe(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{53, 44}), m);
+
+  // Never played, but it is the position after 27 -> 36 seen from the other
+  // side, so the answer is the rotation of 53 -> 44
+  EXPECT_TRUE(s.loadState("1 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 "
+                          "0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 0 0 "
+                          "0 0 0 0 0 0 0 0 2 2 0 0 0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 "
+                          "2"));
+  EXPECT_TRUE(book.probe(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{27, 36}), m);
+
+  // The mirror image of 27 -> 36 is answered by the mirror image of 53 -> 44
+  s.reset();
+  s.applyMove({3, 4});
+  EXPECT_TRUE(book.probe(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{77, 76}), m);
+
+  ChineseCheckers::OpeningBook missing;
+  missing.open("OpeningBook.missing.book");
+  s.reset();
+  EXPECT_FALSE(missing.probe(s, m));
+
+  std::remove(dbPath.c_str());
+  std::remove(bookPath.c_str());
+}
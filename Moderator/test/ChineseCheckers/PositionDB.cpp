@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ChineseCheckers/GameLog.h"
+#include "ChineseCheckers/PositionDB.h"
+#include "ChineseCheckers/State.h"
+
+namespace {
+ChineseCheckers::LoggedGame makeGame(const std::vector<ChineseCheckers::Move> &moves,
+                                     bool player1Wins) {
+  ChineseCheckers::LoggedGame game;
+  game.line = 1;
+  game.player1 = "A";
+  game.player2 = "B";
+  for (const auto m : moves)
+    game.moves.push_back(ChineseCheckers::LoggedMove{m, 0});
+  game.forfeit = ChineseCheckers::Forfeit::None;
+  game.hasFinal = true;
+  game.finalLine = 0;
+  game.winner = player1Wins ? "A" : "B";
+  game.loser = player1Wins ? "B" : "A";
+  return game;
+}
+} // namespace
+
+TEST(PositionDB, Keys) {
+  ChineseCheckers::State s;
+  ChineseCheckers::State loaded;
+
+  std::set<ChineseCheckers::Move> moves;
+  s.getMoves(moves);
+  for (const auto m : moves) {
+    auto key = ChineseCheckers::positionKey(s);
+    EXPECT_TRUE(s.applyMove(m));
+    EXPECT_EQ(ChineseCheckers::positionKey(s), ChineseCheckers::childKey(key, m))
+        << "move = " << m;
+
+    EXPECT_TRUE(ChineseCheckers::loadPositionKey(loaded, ChineseCheckers::positionKey(s)));
+    EXPECT_EQ(s.dumpState(), loaded.dumpState());
+    EXPECT_TRUE(s.undoMove(m));
+  }
+}
+
+TEST(PositionDB, BuildAndMerge) {
+  const std::string path = "PositionDB.test.db";
+
+  ChineseCheckers::PositionDB empty;
+  ChineseCheckers::PositionDBBuilder builder;
+  EXPECT_TRUE(builder.addGame(makeGame({{27, 36}, {53, 44}}, true)));
+  EXPECT_TRUE(builder.addGame(makeGame({{27, 36}, {53, 52}}, false)));
+  EXPECT_TRUE(builder.addGame(makeGame({{2, 4}}, false)));
+  EXPECT_EQ(3u, builder.games());
+  ASSERT_TRUE(builder.write(path, empty));
+
+  ChineseCheckers::PositionDB db;
+  ASSERT_TRUE(db.open(path));
+  // Start, 2 after the first move and 2 after the second
+  EXPECT_EQ(5u, db.size());
+
+  ChineseCheckers::State s;
+  const ChineseCheckers::PositionStats *start = db.find(s);
+  ASSERT_NE(nullptr, start);
+  EXPECT_EQ(3u, start->visits);
+  EXPECT_EQ(1u, start->wins[0]);
+  EXPECT_EQ(2u, start->wins[1]);
+
+  // 27 -> 36 did better for player 1 than 2 -> 4
+  ChineseCheckers::Move m;
+  EXPECT_TRUE(db.bestMove(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{27, 36}), m);
+
+  s.applyMove({3, 12});
+  EXPECT_EQ(nullptr, db.find(s));
+
+  // Merge more games in, replacing the database being read from
+  ChineseCheckers::PositionDBBuilder more;
+  EXPECT_TRUE(more.addGame(makeGame({{2, 4}}, true)));
+  EXPECT_TRUE(more.addGame(makeGame({{2, 4}}, true)));
+  ASSERT_TRUE(more.write(path, db));
+
+  ChineseCheckers::PositionDB merged;
+  ASSERT_TRUE(merged.open(path));
+  EXPECT_EQ(5u, merged.size());
+
+  s.reset();
+  start = merged.find(s);
+  ASSERT_NE(nullptr, start);
+  EXPECT_EQ(5u, start->visits);
+  EXPECT_EQ(3u, start->wins[0]);
+
+  EXPECT_TRUE(merged.bestMove(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{2, 4}), m);
+
+  std::remove(path.c_str());
+}
+
+TEST(PositionDB, StartStates) {
+  const std::string path = "PositionDB.start.test.db";
+
+  // Suite games start where LOADSTATE left them, not at the opening
+  ChineseCheckers::State s;
+  s.applyMove({27, 36});
+  std::string log = "LOADSTATE " + s.dumpState() +
+                    "\nBEGIN CHINESECHECKERS A B\n"
+                    "MOVE FROM 53 TO 44\n"
+                    "FINAL B BEATS A\n"
+                    "LOADSTATE 2 0 1\n"
+                    "BEGIN CHINESECHECKERS A B\n"
+                    "FINAL A BEATS B\n";
+  std::vector<ChineseCheckers::LoggedGame> games;
+  ChineseCheckers::parseGameLog(log.data(), log.data() + log.size(), games);
+  ASSERT_EQ(2u, games.size());
+
+  ChineseCheckers::PositionDB empty;
+  ChineseCheckers::PositionDBBuilder builder;
+  EXPECT_TRUE(builder.addGame(games[0]));
+  EXPECT_FALSE(builder.addGame(games[1]));
+  EXPECT_EQ(1u, builder.games());
+  ASSERT_TRUE(builder.write(path, empty));
+
+  ChineseCheckers::PositionDB db;
+  ASSERT_TRUE(db.open(path));
+  EXPECT_EQ(2u, db.size());
+
+  const ChineseCheckers::PositionStats *start = db.find(s);
+  ASSERT_NE(nullptr, start);
+  EXPECT_EQ(1u, start->visits);
+  EXPECT_EQ(1u, start->wins[1]);
+
+  ChineseCheckers::Move m;
+  EXPECT_TRUE(db.bestMove(s, m));
+  EXPECT_EQ((ChineseCheckers::Move{53, 44}), m);
+
+  ChineseCheckers::State opening;
+  EXPECT_EQ(nullptr, db.find(opening));
+
+  std::remove(path.c_str());
+}
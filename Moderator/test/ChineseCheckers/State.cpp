@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 
 #include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
 #include <string>
 
 #include "ChineseCheckers/State.h"
@@ -499,10 +502,63 @@ TEST(State, LoadDumpState) {
       "0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 2 0";
   EXPECT_FALSE(s.loadState(invalid4));
 
+  // Not a number, which leaves the state as it was
+  std::string invalid5 =
+      "2 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 1 0 0 0 0 "
+      "0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 0 2 2 0 0 "
+      "0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 x";
+  EXPECT_FALSE(s.loadState(invalid5));
+  EXPECT_EQ(starting, s.dumpState());
+
   s.reset();
   EXPECT_EQ(starting, s.dumpState());
 }
 
+TEST(State, LoadStateForgetsHistory) {
+  ChineseCheckers::State s;
+  std::string afterMove =
+      "2 1 1 1 1 0 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 0 0 0 0 0 "
+      "0 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 0 2 2 0 0 "
+      "0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 2";
+  EXPECT_TRUE(s.loadState(afterMove));
+
+  // Coming back to the loaded state is a repeat, the usual start is not
+  s.applyMove({53, 44});
+  s.applyMove({36, 27});
+  EXPECT_FALSE(s.seenDuplicatedState());
+  s.applyMove({44, 53});
+  s.applyMove({27, 36});
+  EXPECT_TRUE(s.seenDuplicatedState());
+}
+
+TEST(State, CompactState) {
+  typedef ChineseCheckers::State::Format Format;
+  ChineseCheckers::State s;
+
+  std::string starting = s.dumpState();
+  std::string compact = s.dumpState(Format::Compact);
+  EXPECT_EQ("015500540050004000000000000008002800a800a802", compact);
+
+  // Either format loads, in either case
+  s.applyMove({27, 36});
+  EXPECT_TRUE(s.loadState(compact));
+  EXPECT_EQ(starting, s.dumpState());
+  s.applyMove({27, 36});
+  EXPECT_TRUE(s.loadState("015500540050004000000000000008002800A800A802"));
+  EXPECT_EQ(starting, s.dumpState());
+
+  char out[ChineseCheckers::State::MaxDumpSize];
+  EXPECT_EQ(starting, std::string(out, s.dumpState(out)));
+  EXPECT_EQ(compact, std::string(out, s.dumpState(out, Format::Compact)));
+
+  // Not hexadecimal, a cell of 3, a third player and the wrong length
+  EXPECT_FALSE(s.loadState("015500540050004000000000000008002800a800a80g"));
+  EXPECT_FALSE(s.loadState("015500540050004000000000000008002800a800a803"));
+  EXPECT_FALSE(s.loadState("035500540050004000000000000008002800a800a802"));
+  EXPECT_FALSE(s.loadState("015500540050004000000000000008002800a800a8"));
+  EXPECT_EQ(starting, s.dumpState());
+}
+
 TEST(State, GameOver) {
   ChineseCheckers::State s;
 
@@ -527,3 +583,188 @@ TEST(State, GameOver) {
   EXPECT_EQ(2, s.winner());
 }
 
+TEST(State, Race) {
+  ChineseCheckers::State s;
+
+  // Nobody is ahead at the start, and the pieces still have to pass
+  EXPECT_EQ(s.raceCount(1), s.raceCount(2));
+  EXPECT_FALSE(s.disengaged());
+  EXPECT_EQ(-1, s.raceWinner());
+  EXPECT_EQ(1, s.raceLeader());
+
+  // Each player is a single step away from winning
+  std::string oneStepEach =
+      "2 2 2 2 0 0 0 0 0 2 2 2 0 0 0 0 0 0 2 2 0 0 0 0 0 0 0 0 0 0 0 0 0 "
+      "0 0 0 2 0 0 0 0 0 0 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1 1 0 0 0 "
+      "0 0 0 1 1 1 0 0 0 0 0 1 1 1 1";
+
+  EXPECT_TRUE(s.loadState("1 " + oneStepEach));
+  EXPECT_TRUE(s.disengaged());
+  EXPECT_EQ(1, s.raceCount(1));
+  EXPECT_EQ(1, s.raceCount(2));
+  EXPECT_EQ(1, s.raceWinner());
+  EXPECT_EQ(1, s.raceLeader());
+
+  EXPECT_TRUE(s.loadState("2 " + oneStepEach));
+  EXPECT_EQ(2, s.raceWinner());
+  EXPECT_EQ(2, s.raceLeader());
+
+  // Player 1 needs two steps, so only player 2 can be sure of winning
+  std::string twoStepsForPlayer1 =
+      "2 2 2 2 0 0 0 0 0 2 2 2 0 0 0 0 0 0 2 2 0 0 0 0 0 0 0 0 0 0 0 0 0 "
+      "0 0 1 2 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1 1 0 0 0 "
+      "0 0 0 1 1 1 0 0 0 0 0 1 1 1 1";
+
+  EXPECT_TRUE(s.loadState("1 " + twoStepsForPlayer1));
+  EXPECT_EQ(2, s.raceCount(1));
+  EXPECT_EQ(-1, s.raceWinner());
+  EXPECT_EQ(2, s.raceLeader());
+
+  EXPECT_TRUE(s.loadState("2 " + twoStepsForPlayer1));
+  EXPECT_EQ(2, s.raceWinner());
+}
+
+
+void CollectRanks(ChineseCheckers::State &s, int depth,
+                  std::map<ChineseCheckers::PositionRank, std::string> &ranks);
+
+void CollectRanks(ChineseCheckers::State &s, int depth,
+                  std::map<ChineseCheckers::PositionRank, std::string> &ranks) {
+  ChineseCheckers::PositionRank rank;
+  ASSERT_TRUE(s.getRank(rank)) << s.dumpState();
+
+  auto inserted = ranks.insert(std::make_pair(rank, s.dumpState()));
+  EXPECT_EQ(inserted.first->second, s.dumpState()) << "rank = " << rank;
+
+  if (depth == 0)
+    return;
+
+  std::set<ChineseCheckers::Move> moves;
+  s.getMoves(moves);
+  for (const auto m : moves) {
+    s.applyMove(m);
+    CollectRanks(s, depth - 1, ranks);
+    s.undoMove(m);
+  }
+}
+
+TEST(State, RankRoundTrip) {
+  ChineseCheckers::State s;
+
+  std::map<ChineseCheckers::PositionRank, std::string> ranks;
+  CollectRanks(s, 2, ranks);
+
+  ChineseCheckers::State loaded;
+  for (const auto &r : ranks) {
+    EXPECT_TRUE(loaded.loadRank(r.first));
+    EXPECT_EQ(r.second, loaded.dumpState());
+
+    uint8_t bytes[ChineseCheckers::PositionRank::NumBytes];
+    r.first.write(bytes);
+    EXPECT_EQ(r.first, ChineseCheckers::PositionRank::read(bytes));
+  }
+}
+
+TEST(State, PackedRoundTrip) {
+  ChineseCheckers::State s;
+
+  std::map<ChineseCheckers::PositionRank, std::string> ranks;
+  CollectRanks(s, 2, ranks);
+
+  ChineseCheckers::State loaded;
+  uint8_t bytes[ChineseCheckers::State::PackedBytes];
+  for (const auto &r : ranks) {
+    EXPECT_TRUE(s.loadState(r.second));
+    s.writePacked(bytes);
+    EXPECT_TRUE(loaded.loadPacked(bytes));
+    EXPECT_EQ(r.second, loaded.dumpState());
+  }
+
+  // Neither a third player nor a cell of 3 can be loaded
+  bytes[0] = 3;
+  EXPECT_FALSE(loaded.loadPacked(bytes));
+  bytes[0] = 1;
+  bytes[5] = 0xff;
+  EXPECT_FALSE(loaded.loadPacked(bytes));
+  EXPECT_EQ(ranks.rbegin()->second, loaded.dumpState());
+}
+
+TEST(State, RankBounds) {
+  ChineseCheckers::State s;
+
+  // The first rank packs each player into the lowest cells left
+  EXPECT_TRUE(s.loadRank(ChineseCheckers::PositionRank(0, 0)));
+  EXPECT_EQ("1 1 1 1 1 1 1 1 1 1 1 2 2 2 2 2 2 2 2 2 2 0 0 0 0 0 0 0 0 0 0 0 "
+            "0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 "
+            "0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0",
+            s.dumpState());
+
+  // 2 * C(81, 10) * C(71, 10) - 1 is the last
+  ChineseCheckers::PositionRank last(0x16f53, 0x97a1169ebd20ef7full);
+  EXPECT_TRUE(s.loadRank(last));
+  EXPECT_EQ("2 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 "
+            "0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 "
+            "2 2 2 2 2 2 2 2 2 2 1 1 1 1 1 1 1 1 1 1",
+            s.dumpState());
+
+  ChineseCheckers::PositionRank rank;
+  EXPECT_TRUE(s.getRank(rank));
+  EXPECT_EQ(last, rank);
+
+  EXPECT_FALSE(s.loadRank(ChineseCheckers::PositionRank(0x16f53, 0x97a1169ebd20ef80ull)));
+  EXPECT_FALSE(s.loadRank(ChineseCheckers::PositionRank(~0ull, ~0ull)));
+
+  // Only positions with 10 pieces a side have a rank
+  std::string extraPiece =
+      "1 1 1 1 1 1 0 0 0 0 1 1 1 0 0 0 0 0 0 1 1 0 0 0 0 0 0 0 1 0 0 0 0 "
+      "0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 2 0 0 0 0 0 0 0 2 2 0 0 "
+      "0 0 0 0 2 2 2 0 0 0 0 0 2 2 2 2";
+  EXPECT_TRUE(s.loadState(extraPiece));
+  EXPECT_FALSE(s.getRank(rank));
+}
+
+TEST(State, Symmetry) {
+  ChineseCheckers::State s;
+
+  for (const auto symmetry :
+       {ChineseCheckers::Symmetry::Identity, ChineseCheckers::Symmetry::Transpose,
+        ChineseCheckers::Symmetry::Rotate, ChineseCheckers::Symmetry::AntiTranspose}) {
+    for (unsigned i = 0; i < 81; ++i)
+      EXPECT_EQ(i, ChineseCheckers::transformCell(
+                       ChineseCheckers::transformCell(i, symmetry), symmetry));
+  }
+
+  // The start is its own transpose, and its own rotation once the player to
+  // move is swapped back
+  ChineseCheckers::Symmetry symmetry;
+  auto start = s.getCanonicalHash(symmetry);
+  EXPECT_EQ(ChineseCheckers::Symmetry::Identity, symmetry);
+  EXPECT_EQ(start, s.getSymmetricHash(ChineseCheckers::Symmetry::Transpose));
+  EXPECT_FALSE(start == s.getSymmetricHash(ChineseCheckers::Symmetry::Rotate));
+
+  // 27 -> 36 and its mirror image 3 -> 4 share a canonical state
+  ChineseCheckers::Move m{27, 36};
+  EXPECT_EQ((ChineseCheckers::Move{3, 4}),
+            ChineseCheckers::transformMove(m, ChineseCheckers::Symmetry::Transpose));
+
+  ChineseCheckers::Symmetry first, second;
+  s.applyMove(m);
+  auto canonical = s.getCanonicalHash(first);
+  s.reset();
+  s.applyMove({3, 4});
+  EXPECT_EQ(canonical, s.getCanonicalHash(second));
+  EXPECT_FALSE(first == second);
+
+  // A reply found for the canonical state maps to a valid reply in each
+  std::set<ChineseCheckers::Move> moves;
+  s.getMoves(moves);
+  for (const auto reply : moves) {
+    auto canonicalReply = ChineseCheckers::transformMove(reply, second);
+    s.reset();
+    s.applyMove(m);
+    EXPECT_TRUE(s.isValidMove(ChineseCheckers::transformMove(canonicalReply, first)))
+        << reply;
+    s.reset();
+    s.applyMove({3, 4});
+  }
+}
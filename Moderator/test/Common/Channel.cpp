@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <unistd.h>
+
+#include "Common/Channel.h"
+
+namespace {
+// A pipe whose ends are closed with it
+struct Pipe {
+  Pipe() { EXPECT_EQ(0, pipe(fds)); }
+  ~Pipe() {
+    closeWrite();
+    close(fds[0]);
+  }
+  void send(const std::string &text) {
+    EXPECT_EQ(static_cast<ssize_t>(text.size()),
+              ::write(fds[1], text.data(), text.size()));
+  }
+  std::string receive() {
+    char buffer[256];
+    ssize_t got = read(fds[0], buffer, sizeof(buffer));
+    return got > 0 ? std::string(buffer, static_cast<size_t>(got)) : "";
+  }
+  void closeWrite() {
+    if (fds[1] >= 0)
+      close(fds[1]);
+    fds[1] = -1;
+  }
+  int fds[2];
+};
+} // namespace
+
+TEST(Channel, readLine) {
+  Pipe input;
+  Common::Channel channel(input.fds[0], -1);
+  std::string line;
+
+  input.send("BEGIN\r\nMOVE FROM 1");
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("BEGIN", line);
+  // Half a line is not a line
+  EXPECT_FALSE(channel.readLine(line, 0.01));
+
+  input.send(" TO 2\n\nEND");
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("MOVE FROM 1 TO 2", line);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("", line);
+
+  // The rest of the input is the last line, then only empty ones follow
+  input.closeWrite();
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("END", line);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("", line);
+}
+
+TEST(Channel, longLines) {
+  Pipe input;
+  Common::Channel channel(input.fds[0], -1);
+  std::string line;
+
+  // Lines wrap around the ring and outgrow it
+  std::string longLine(10000, 'x');
+  for (int i = 0; i < 3; ++i) {
+    input.send(std::string(1000, 'a') + "\n");
+    EXPECT_TRUE(channel.readLine(line, 1.0));
+    EXPECT_EQ(std::string(1000, 'a'), line);
+  }
+  input.send(longLine.substr(0, 5000));
+  EXPECT_FALSE(channel.readLine(line, 0.01));
+  input.send(longLine.substr(5000) + "\nshort\n");
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ(longLine, line);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("short", line);
+}
+
+TEST(Channel, write) {
+  Pipe input, output;
+  Common::Channel channel(input.fds[0], output.fds[1]);
+
+  channel.write("MOVE FROM 1 TO 2");
+  channel.write("#quit");
+  // Nothing is written until flushed
+  input.send("\n");
+  std::string line;
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_TRUE(channel.flush());
+  EXPECT_EQ("MOVE FROM 1 TO 2\n#quit\n", output.receive());
+
+  // A read that has to wait flushes first
+  channel.write("DUMPSTATE");
+  EXPECT_FALSE(channel.readLine(line, 0.01));
+  EXPECT_EQ("DUMPSTATE\n", output.receive());
+}
+
+namespace {
+size_t testFrameSize(char type) {
+  return type == 1 ? 3 : 0;
+}
+} // namespace
+
+TEST(Channel, frames) {
+  Pipe input, output;
+  Common::Channel channel(input.fds[0], output.fds[1]);
+  std::string line;
+
+  // Before frames are read a frame is just part of a line
+  input.send(std::string("\1\n\2") + "\nA\n");
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("\1", line);
+
+  channel.setFrameSize(testFrameSize);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("\2", line);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("A", line);
+
+  // Frames may hold newlines and are read whole, between lines
+  input.send(std::string("\1\n"));
+  EXPECT_FALSE(channel.readLine(line, 0.01));
+  input.send(std::string("\n\1\2\3B \n"));
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ(std::string("\1\n\n"), line);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ(std::string("\1\2\3"), line);
+  EXPECT_TRUE(channel.readLine(line, 1.0));
+  EXPECT_EQ("B", line);
+
+  channel.writeFrame(std::string("\1\n\0", 3));
+  channel.write("C");
+  EXPECT_TRUE(channel.flush());
+  EXPECT_EQ(std::string("\1\n\0C\n", 5), output.receive());
+}
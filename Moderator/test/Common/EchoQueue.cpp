@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "Common/EchoQueue.h"
+
+TEST(EchoQueue, inOrder) {
+  Common::EchoQueue echoes;
+  EXPECT_FALSE(echoes.pop("MOVE FROM 27 TO 36"));
+
+  echoes.push("MOVE FROM 27 TO 36");
+  echoes.push("TIME 1000 2000");
+  EXPECT_EQ(2u, echoes.size());
+
+  // Only the oldest can come back next
+  EXPECT_FALSE(echoes.pop("TIME 1000 2000"));
+  EXPECT_FALSE(echoes.pop("1 MOVE FROM 27 TO 36"));
+  EXPECT_FALSE(echoes.pop("MOVE FROM 27 TO 3"));
+  EXPECT_TRUE(echoes.pop("MOVE FROM 27 TO 36"));
+  EXPECT_TRUE(echoes.pop("TIME 1000 2000"));
+  EXPECT_TRUE(echoes.empty());
+}
+
+TEST(EchoQueue, duplicates) {
+  Common::EchoQueue echoes;
+
+  // Identical broadcasts are each echoed
+  echoes.push("TIME 1000 1000");
+  echoes.push("TIME 1000 1000");
+  echoes.push("FINAL A BEATS B");
+  EXPECT_TRUE(echoes.pop("TIME 1000 1000"));
+  EXPECT_FALSE(echoes.pop("FINAL A BEATS B"));
+  EXPECT_TRUE(echoes.pop("TIME 1000 1000"));
+  EXPECT_TRUE(echoes.pop("FINAL A BEATS B"));
+  EXPECT_FALSE(echoes.pop("TIME 1000 1000"));
+
+  // Storage is reused once everything has come back
+  echoes.push("BEGIN CHINESECHECKERS A B");
+  EXPECT_EQ(1u, echoes.size());
+  EXPECT_TRUE(echoes.pop("BEGIN CHINESECHECKERS A B"));
+}
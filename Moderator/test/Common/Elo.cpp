@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "Common/Elo.h"
+
+TEST(Elo, Score) {
+  EXPECT_DOUBLE_EQ(0.0, Common::eloFromScore(0.5));
+  EXPECT_NEAR(190.85, Common::eloFromScore(0.75), 0.01);
+  EXPECT_NEAR(-190.85, Common::eloFromScore(0.25), 0.01);
+  EXPECT_NEAR(0.75, Common::scoreFromElo(Common::eloFromScore(0.75)), 1e-12);
+}
+
+TEST(Elo, Estimate) {
+  auto even = Common::estimateElo(50, 0, 50);
+  EXPECT_NEAR(0.0, even.elo, 1e-9);
+  // A score of 0.5 +- 1.96 * 0.05
+  EXPECT_NEAR(Common::eloFromScore(0.5 + 1.959963984540054 * 0.05), even.error, 0.01);
+
+  auto ahead = Common::estimateElo(60, 20, 20);
+  EXPECT_NEAR(Common::eloFromScore(0.7), ahead.elo, 1e-9);
+  EXPECT_GT(ahead.error, 0.0);
+
+  // More games narrow the interval
+  EXPECT_LT(Common::estimateElo(600, 200, 200).error, ahead.error);
+
+  EXPECT_TRUE(std::isinf(Common::estimateElo(10, 0, 0).elo));
+  EXPECT_TRUE(std::isinf(Common::estimateElo(0, 0, 0).error));
+}
+
+TEST(Elo, SPRT) {
+  double lower, upper;
+  Common::sprtBounds(0.05, 0.05, lower, upper);
+  EXPECT_NEAR(-2.944, lower, 0.001);
+  EXPECT_NEAR(2.944, upper, 0.001);
+
+  // Scoring exactly halfway between the hypotheses says nothing
+  EXPECT_NEAR(0.0, Common::sprtLLR(500, 0, 500, -10, 10), 1e-9);
+
+  // A clearly stronger agent is accepted, a clearly weaker one rejected
+  EXPECT_GT(Common::sprtLLR(600, 0, 400, 0, 10), upper);
+  EXPECT_LT(Common::sprtLLR(400, 0, 600, 0, 10), lower);
+
+  // The evidence grows with the number of games
+  EXPECT_GT(Common::sprtLLR(120, 0, 100, 0, 10), Common::sprtLLR(12, 0, 10, 0, 10));
+
+  EXPECT_DOUBLE_EQ(0.0, Common::sprtLLR(0, 0, 0, 0, 10));
+
+  // Records of only losses or only wins end the test too
+  unsigned games = 1;
+  while (games < 1000 && Common::sprtLLR(0, 0, games, 0, 10) > lower)
+    ++games;
+  EXPECT_GT(1000u, games);
+  EXPECT_LT(Common::sprtLLR(0, 0, games, 0, 10), Common::sprtLLR(0, 0, 1, 0, 10));
+  EXPECT_GT(Common::sprtLLR(1000, 0, 0, 0, 10), upper);
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include <climits>
+#include <string>
+
+#include "Common/Format.h"
+
+TEST(FormatBuffer, numbers) {
+  char buffer[128];
+  Common::FormatBuffer out(buffer);
+
+  out << 0 << ' ' << -7 << ' ' << 81u << ' ' << LLONG_MIN << ' ' << ULLONG_MAX;
+  EXPECT_EQ("0 -7 81 -9223372036854775808 18446744073709551615", out.str());
+
+  // Doubles are written as std::ostream writes them
+  out.clear();
+  out << 30.0 << ' ' << 0.25 << ' ' << 1234567.0;
+  EXPECT_EQ("30 0.25 1.23457e+06", out.str());
+
+  out.clear();
+  out.padded(5, 2) << '|';
+  out.padded(-42, 2) << '|';
+  out.fixed(2.0 / 3, 3) << '|';
+  out.fixed(1.25, 1);
+  EXPECT_EQ(" 5|-42|0.667|1.2", out.str());
+}
+
+TEST(FormatBuffer, outgrowsBuffer) {
+  char buffer[8];
+  Common::FormatBuffer out(buffer);
+
+  out << "MOVE";
+  EXPECT_EQ(buffer, out.str().data());
+  // Nothing is cut off once the text no longer fits
+  std::string name(100, 'x');
+  out << ' ' << name << ' ' << 12345;
+  EXPECT_EQ("MOVE " + name + " 12345", out.str());
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include "Common/Logger.h"
+
+TEST(Logger, drainsOnDestruction) {
+  std::stringstream out;
+  {
+    Common::Logger logger(out, 10.0);
+    logger.append("# ");
+    logger.write("MOVE FROM 27 TO 36");
+    logger.write("FINAL A BEATS B");
+  }
+  EXPECT_EQ("# MOVE FROM 27 TO 36\nFINAL A BEATS B\n", out.str());
+}
+
+TEST(Logger, fullRing) {
+  // Far more than the ring holds at once, so writing waits for room
+  std::stringstream out;
+  std::string expected;
+  {
+    Common::Logger logger(out, 0.001, 16);
+    for (int i = 0; i < 1000; ++i) {
+      std::string line = "line " + std::to_string(i);
+      logger.write(line);
+      expected += line + "\n";
+    }
+  }
+  EXPECT_EQ(expected, out.str());
+}
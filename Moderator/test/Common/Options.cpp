@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "Common/Options.h"
+
+namespace {
+// Parses every argument as an option, returning those that are not
+std::vector<std::string> parse(std::vector<std::string> args,
+                               Common::MatchSpec &spec) {
+  std::vector<char *> argv;
+  for (auto &arg : args)
+    argv.push_back(&arg[0]);
+
+  std::vector<std::string> rest;
+  int argc = static_cast<int>(argv.size());
+  for (int i = 0; i < argc; ++i) {
+    if (!Common::parseMatchOption(argc, argv.data(), i, spec))
+      rest.push_back(argv[static_cast<size_t>(i)]);
+  }
+  return rest;
+}
+} // namespace
+
+TEST(Options, parseMatchOption) {
+  Common::MatchSpec spec;
+  auto rest = parse({"--enforce", "2.5", "--clock", "60+0.5", "--max-plies",
+                     "300", "--memory", "64", "--cpus", "0-1", "--async-log",
+                     "10", "--adjudicate", "AGENT"},
+                    spec);
+  EXPECT_EQ(std::vector<std::string>{"AGENT"}, rest);
+  EXPECT_TRUE(spec.options.enforceTimeLimit);
+  EXPECT_DOUBLE_EQ(2.5, spec.options.turnTimeLimit);
+  EXPECT_DOUBLE_EQ(60.0, spec.options.clockBase);
+  EXPECT_DOUBLE_EQ(0.5, spec.options.clockIncrement);
+  EXPECT_EQ(300, spec.options.maxPlies);
+  EXPECT_EQ(64u * 1024 * 1024, spec.memoryLimit);
+  EXPECT_EQ((std::vector<int>{0, 1}), spec.agents.cpus);
+  EXPECT_DOUBLE_EQ(0.01, spec.options.logFlushInterval);
+  EXPECT_TRUE(spec.options.adjudicateRaces);
+
+  // The limit of --enforce is optional, and bad values change nothing
+  Common::MatchSpec other;
+  rest = parse({"--enforce", "AGENT", "--max-plies", "x", "--async-log", "5ms",
+                "--clock"},
+               other);
+  EXPECT_EQ((std::vector<std::string>{"AGENT", "--clock"}), rest);
+  EXPECT_TRUE(other.options.enforceTimeLimit);
+  EXPECT_DOUBLE_EQ(30.0, other.options.turnTimeLimit);
+  EXPECT_EQ(0, other.options.maxPlies);
+  EXPECT_DOUBLE_EQ(0.0, other.options.logFlushInterval);
+}
+
+TEST(Options, numbers) {
+  EXPECT_EQ(4, Common::parseCount("4", 1));
+  EXPECT_EQ(1, Common::parseCount("0", 7));
+  EXPECT_EQ(7, Common::parseCount("4x", 7));
+  EXPECT_EQ(7, Common::parseCount("99999999999", 7));
+
+  double value = 1.0;
+  EXPECT_TRUE(Common::parseDouble("-2.5", value));
+  EXPECT_DOUBLE_EQ(-2.5, value);
+  EXPECT_FALSE(Common::parseDouble("2.5x", value));
+  EXPECT_DOUBLE_EQ(-2.5, value);
+}
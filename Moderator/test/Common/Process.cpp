@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "Common/Process.h"
+
+TEST(Process, splitCommand) {
+  auto args = Common::splitCommand("./agent  name --book x");
+  ASSERT_EQ(4u, args.size());
+  EXPECT_EQ("./agent", args[0]);
+  EXPECT_EQ("name", args[1]);
+  EXPECT_EQ("x", args[3]);
+}
+
+TEST(Process, Pipes) {
+  Common::Process p;
+  ASSERT_TRUE(p.start({"cat"}));
+  EXPECT_TRUE(p.running());
+
+  std::string msg = "MOVE FROM 27 TO 36\n";
+  ASSERT_EQ(static_cast<ssize_t>(msg.size()), write(p.input(), msg.data(), msg.size()));
+
+  // cat echoes it back once it gets around to it
+  std::string echo;
+  while (echo.size() < msg.size()) {
+    pollfd fd{p.output(), POLLIN, 0};
+    ASSERT_EQ(1, poll(&fd, 1, 5000));
+
+    char buffer[64];
+    ssize_t got = read(p.output(), buffer, sizeof(buffer));
+    ASSERT_GT(got, 0);
+    echo.append(buffer, static_cast<size_t>(got));
+  }
+  EXPECT_EQ(msg, echo);
+
+  p.stop();
+  EXPECT_FALSE(p.running());
+  EXPECT_EQ(-1, p.output());
+}
+
+TEST(Process, Missing) {
+  Common::Process p;
+  EXPECT_FALSE(p.start({"./no-such-agent"}));
+  EXPECT_FALSE(p.running());
+  EXPECT_FALSE(p.start({}));
+}
+
+TEST(Process, parseCpuList) {
+  std::vector<int> cpus;
+  EXPECT_TRUE(Common::parseCpuList("0-2,5", cpus));
+  EXPECT_EQ((std::vector<int>{0, 1, 2, 5}), cpus);
+
+  for (const char *bad : {"", "a", "3-1", "1,,2", "-1", "2-", "1048576",
+                          "0-2000000000", "2147483646-2147483647",
+                          "0-99999999999"}) {
+    EXPECT_FALSE(Common::parseCpuList(bad, cpus)) << bad;
+    EXPECT_EQ(4u, cpus.size());
+  }
+}
+
+TEST(Process, CpuTime) {
+  Common::Process p;
+  EXPECT_DOUBLE_EQ(-1.0, p.cpuTime());
+
+  // The shell spins in a child, which is counted once it is reaped
+  ASSERT_TRUE(p.start({"sh", "-c", "sh -c 'i=0; while [ $i -lt 300000 ]; do i=$((i+1)); done'; echo done"}));
+  pollfd fd{p.output(), POLLIN, 0};
+  ASSERT_EQ(1, poll(&fd, 1, 30000));
+#ifdef __linux__
+  EXPECT_GT(p.cpuTime(), 0.0);
+#endif
+
+  p.stop();
+  EXPECT_GT(p.cpuTime(), 0.0);
+}
+
+TEST(Process, Memory) {
+  size_t bytes = 7;
+  EXPECT_TRUE(Common::parseMegabytes("64", bytes));
+  EXPECT_EQ(64u * 1024 * 1024, bytes);
+  for (const char *bad : {"", "0", "-1", "12MB", "x"}) {
+    EXPECT_FALSE(Common::parseMegabytes(bad, bytes)) << bad;
+    EXPECT_EQ(64u * 1024 * 1024, bytes);
+  }
+
+  Common::Process p;
+  ASSERT_TRUE(p.start({"cat"}));
+#ifdef __linux__
+  EXPECT_GT(p.peakMemory(), 0);
+#endif
+  p.stop();
+  EXPECT_EQ(-1, p.peakMemory());
+
+  // Too little address space to even load a program, so either the exec
+  // fails or the program dies loading
+  Common::ProcessOptions options;
+  options.addressSpaceLimit = 1024 * 1024;
+  if (p.start({"sh", "-c", "cat; echo exited"}, options)) {
+    pollfd fd{p.output(), POLLIN, 0};
+    ASSERT_EQ(1, poll(&fd, 1, 5000));
+    char buffer[64];
+    EXPECT_GE(0, read(p.output(), buffer, sizeof(buffer)));
+  }
+}
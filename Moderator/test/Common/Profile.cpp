@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "Common/Profile.h"
+
+TEST(Profile, summarizeZone) {
+  // Each test has its own zone, the counts last as long as the program
+  for (uint64_t i = 1; i <= 100; ++i)
+    Common::recordZone(Common::Zone::Apply, i * 1000);
+
+  Common::ZoneSummary summary = Common::summarizeZone(Common::Zone::Apply);
+  EXPECT_EQ(100u, summary.count);
+  EXPECT_EQ(5050000u, summary.total);
+  EXPECT_EQ(100000u, summary.max);
+  // Percentiles are the top of their bucket, within a quarter of the time
+  EXPECT_LE(50000u, summary.p50);
+  EXPECT_GE(62500u, summary.p50);
+  EXPECT_LE(90000u, summary.p90);
+  EXPECT_GE(112500u, summary.p90);
+  EXPECT_LE(99000u, summary.p99);
+  EXPECT_GE(100000u, summary.p99);
+
+  // Small times are exact
+  Common::recordZone(Common::Zone::Validate, 3);
+  summary = Common::summarizeZone(Common::Zone::Validate);
+  EXPECT_EQ(3u, summary.p50);
+  EXPECT_EQ(3u, summary.p99);
+}
+
+TEST(Profile, threads) {
+  std::thread other([]() noexcept {
+    Common::ProfileZone zone(Common::Zone::Search);
+  });
+  other.join();
+  {
+    Common::ProfileZone zone(Common::Zone::Search);
+  }
+  EXPECT_EQ(2u, Common::summarizeZone(Common::Zone::Search).count);
+
+  // Only zones that were entered are written
+  std::ostringstream out;
+  Common::writeProfile(out);
+  EXPECT_NE(std::string::npos, out.str().find("PROFILE | search | Count: 2 |"));
+  EXPECT_EQ(std::string::npos, out.str().find("movegen"));
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <climits>
 #include <string>
+#include <vector>
 
 #include "Common/String.h"
 
@@ -35,3 +37,59 @@ TEST(String, split) {
   for (size_t i = 0, e = expected.size(); i != e; ++i)
     EXPECT_EQ(expected[i], tokenized[i]) << "i = " << i;
 }
+
+TEST(String, tokenize) {
+  std::string src = "MOVE FROM 27  TO 36 ";
+  Common::Tokens tokens;
+  Common::tokenize(src, tokens);
+
+  // Matches split, including the empty token between two delimiters
+  std::vector<std::string> expected = Common::split(src);
+  ASSERT_EQ(expected.size(), tokens.size());
+  for (size_t i = 0, e = expected.size(); i != e; ++i)
+    EXPECT_EQ(expected[i], tokens[i].str()) << "i = " << i;
+  EXPECT_TRUE(tokens[3].empty());
+  EXPECT_EQ(src.data() + 5, tokens[1].data());
+
+  // The storage is kept between messages
+  const Common::StringRef *storage = tokens.data();
+  Common::tokenize("a,b", tokens, ',');
+  ASSERT_EQ(2u, tokens.size());
+  EXPECT_EQ(storage, tokens.data());
+  EXPECT_TRUE(tokens[0] == "a");
+  EXPECT_TRUE(tokens[1] != "a");
+
+  Common::tokenize("", tokens);
+  EXPECT_TRUE(tokens.empty());
+}
+
+TEST(String, parseInt) {
+  int value = 7;
+  EXPECT_EQ(Common::ParseError::None, Common::parseInt("42", value));
+  EXPECT_EQ(42, value);
+  EXPECT_EQ(Common::ParseError::None, Common::parseInt("-2147483648", value));
+  EXPECT_EQ(INT_MIN, value);
+  EXPECT_EQ(Common::ParseError::None, Common::parseInt("2147483647", value));
+  EXPECT_EQ(INT_MAX, value);
+
+  value = 7;
+  EXPECT_EQ(Common::ParseError::OutOfRange, Common::parseInt("2147483648", value));
+  EXPECT_EQ(Common::ParseError::OutOfRange,
+            Common::parseInt("-99999999999999999999999", value));
+  EXPECT_EQ(Common::ParseError::Invalid, Common::parseInt("", value));
+  EXPECT_EQ(Common::ParseError::Invalid, Common::parseInt("-", value));
+  EXPECT_EQ(Common::ParseError::Invalid, Common::parseInt(" 1", value));
+  EXPECT_EQ(Common::ParseError::Invalid, Common::parseInt("12abc", value));
+  EXPECT_EQ(7, value);
+}
+
+TEST(String, parseUnsigned) {
+  unsigned value = 7;
+  EXPECT_EQ(Common::ParseError::None, Common::parseUnsigned("80", value));
+  EXPECT_EQ(80u, value);
+  EXPECT_EQ(Common::ParseError::None, Common::parseUnsigned("4294967295", value));
+  EXPECT_EQ(UINT_MAX, value);
+  EXPECT_EQ(Common::ParseError::OutOfRange, Common::parseUnsigned("4294967296", value));
+  EXPECT_EQ(Common::ParseError::Invalid, Common::parseUnsigned("-1", value));
+  EXPECT_EQ(Common::ParseError::Invalid, Common::parseUnsigned("", value));
+}
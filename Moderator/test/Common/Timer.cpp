@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+
+#include "Common/Timer.h"
+
+TEST(Timer, pollTimeout) {
+  EXPECT_EQ(-1, Common::pollTimeout(std::numeric_limits<double>::infinity()));
+  EXPECT_EQ(0, Common::pollTimeout(-0.5));
+  EXPECT_EQ(0, Common::pollTimeout(0.0));
+  // Waits are rounded up rather than cut short
+  EXPECT_EQ(1, Common::pollTimeout(0.0001));
+  EXPECT_EQ(1500, Common::pollTimeout(1.5));
+}
+
+TEST(Timer, parseTimeControl) {
+  double base = 1, increment = 2;
+  EXPECT_TRUE(Common::parseTimeControl("60+0.5", base, increment));
+  EXPECT_DOUBLE_EQ(60.0, base);
+  EXPECT_DOUBLE_EQ(0.5, increment);
+
+  EXPECT_TRUE(Common::parseTimeControl("90", base, increment));
+  EXPECT_DOUBLE_EQ(90.0, base);
+  EXPECT_DOUBLE_EQ(0.0, increment);
+
+  for (const char *bad : {"", "+1", "0+1", "60+", "60+x", "60s", "-5"}) {
+    EXPECT_FALSE(Common::parseTimeControl(bad, base, increment)) << bad;
+    EXPECT_DOUBLE_EQ(90.0, base);
+  }
+}
@@ -118,6 +118,8 @@ std::vector<std::string> Agent::tokenizeMsg(const std::string &msg) const {
 }
 
 void Agent::waitForStart() {
+  // The last state loaded is where the game starts, if there was one
+  std::string start_state;
   for (;;) {
     std::string response = readMsg();
     std::vector<std::string> tokens = tokenizeMsg(response);
@@ -148,7 +150,9 @@ void Agent::waitForStart() {
       std::cout << state.dumpState() << std::endl;
     } else if (tokens[0] == "LOADSTATE") {
       std::string new_state = response.substr(10);
-      if (!state.loadState(new_state))
+      if (state.loadState(new_state))
+        start_state = new_state;
+      else
         std::cerr << "Failed to load '" << new_state << "'\n";
     } else if (response == "LISTMOVES") {
       std::vector<Move> moves;
@@ -180,9 +184,11 @@ void Agent::waitForStart() {
   // Game is about to begin, restore to start state in case DUMPSTATE/LOADSTATE/LISTMOVES
   // were used
   state.reset();
+  if (!start_state.empty())
+    state.loadState(start_state);
 
-  // Player 1 goes first
-  current_player = player1;
+  // Player 1 goes first unless the start state says otherwise
+  current_player = start_state.compare(0, 1, "2") == 0 ? player2 : player1;
 }
 
 void Agent::switchCurrentPlayer() {
@@ -112,6 +112,8 @@ public class Agent {
   private String[] tokenize(String s) { return s.split(" "); }
 
   private void waitForStart() {
+    // The last state loaded is where the game starts, if there was one
+    String startState = null;
     for (;;) {
       String response = readMessage();
       String[] tokens = tokenize(response);
@@ -143,7 +145,9 @@ public class Agent {
         System.out.flush();
       } else if (tokens[0].equals("LOADSTATE")) {
         String newState = response.substring(10);
-        if (!state.loadState(newState)) {
+        if (state.loadState(newState)) {
+          startState = newState;
+        } else {
           System.err.println("Unable to load '" + newState + "'");
           System.err.flush();
         }
@@ -183,9 +187,13 @@ public class Agent {
     // DUMPSTATE/LOADSTATE/LISTMOVES
     // were used
     state.reset();
+    if (startState != null) {
+      state.loadState(startState);
+    }
 
-    // Player 1 goes first
-    current_player = Players.player1;
+    // Player 1 goes first unless the start state says otherwise
+    current_player = startState != null && startState.startsWith("2")
+        ? Players.player2 : Players.player1;
   }
 
   private void switchCurrentPlayer() {
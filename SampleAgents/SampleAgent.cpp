@@ -154,6 +154,8 @@ std::vector<std::string> Client::tokenize_msg(const std::string &msg) const {
 }
 
 void Client::wait_for_start() {
+  // The last state loaded is where the game starts, if there was one
+  std::string start_state;
   for (;;) {
     std::string response = read_msg();
     const std::vector<std::string> tokens = tokenize_msg(response);
@@ -184,6 +186,7 @@ void Client::wait_for_start() {
       // std::cout << gs.dumpState() << std::endl;
     } else if (tokens[0] == "LOADSTATE") {
       std::string new_state = response.substr(10);
+      start_state = new_state;
       /*
       if (!gs.loadState(new_state))
         std::cerr << "Failed to load '" << new_state << "'\n";
@@ -208,9 +211,12 @@ void Client::wait_for_start() {
   // Game is about to begin, restore to start state in case DUMPSTATE/LOADSTATE/LISTMOVES
   // were used
   //gs.reset();
+  // The game starts from the last state loaded, if there was one
+  //if (!start_state.empty())
+  //  gs.loadState(start_state);
 
-  // Player 1 goes first
-  current_player = player1;
+  // Player 1 goes first unless the start state says otherwise
+  current_player = start_state.compare(0, 1, "2") == 0 ? player2 : player1;
 }
 
 void Client::switch_current_player() {
@@ -110,6 +110,8 @@ public class SampleAgent {
   private String[] tokenize(String s) { return s.split(" "); }
 
   private void waitForStart() {
+    // The last state loaded is where the game starts, if there was one
+    String startState = null;
     while (true) {
       String response = readMessage();
       String[] tokens = tokenize(response);
@@ -140,9 +142,9 @@ public class SampleAgent {
         // System.out.println(gs.dumpState());
         // System.out.flush();
       } else if (tokens[0].equals("LOADSTATE")) {
-        // String newState = response.substring(10);
-        // System.out.println(gs.loadState(newState));
-        // System.out.flush();
+        String newState = response.substring(10);
+        // if (gs.loadState(newState))
+        startState = newState;
       } else if (tokens[0].equals("MOVE")) {
         // Move m = gs.translateToLocal(tokens);
         // gs.applyMove(m);
@@ -155,9 +157,12 @@ public class SampleAgent {
     // Game is about to begin, restore to start state in case DUMPSTATE/LOADSTATE/LISTMOVES
     // were used
     //gs.reset();
+    //if (startState != null)
+    //  gs.loadState(startState);
 
-    // Player 1 goes first
-    currentPlayer = Players.player1;
+    // Player 1 goes first unless the start state says otherwise
+    currentPlayer = startState != null && startState.startsWith("2")
+        ? Players.player2 : Players.player1;
   }
 
   private Scanner stdin;